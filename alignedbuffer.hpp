@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Heap array whose first element starts on an ALIGNMENT byte boundary. Plain
+// over-allocation, so it works with every standard library the project
+// builds against. Storage only ever grows: resizing within the capacity
+// reached so far neither allocates nor touches the contents.
+template <typename T, size_t ALIGNMENT = 64>
+class AlignedBuffer
+{
+public:
+    AlignedBuffer() :
+        data_(nullptr),
+        size_(0),
+        capacity_(0)
+    {
+    }
+
+    AlignedBuffer(const AlignedBuffer &) = delete;
+    AlignedBuffer &operator=(const AlignedBuffer &) = delete;
+
+    void resize(size_t size)
+    {
+        if (size > capacity_)
+        {
+            storage_.assign(size * sizeof(T) + ALIGNMENT, 0);
+            const uintptr_t base = reinterpret_cast<uintptr_t>(storage_.data());
+            data_ = reinterpret_cast<T *>((base + ALIGNMENT - 1) & ~(uintptr_t)(ALIGNMENT - 1));
+            capacity_ = size;
+        }
+        size_ = size;
+    }
+
+    T *data()
+    {
+        return data_;
+    }
+
+    const T *data() const
+    {
+        return data_;
+    }
+
+    size_t size() const
+    {
+        return size_;
+    }
+
+    size_t capacity() const
+    {
+        return capacity_;
+    }
+
+private:
+    std::vector<unsigned char> storage_;
+    T *data_;
+    size_t size_;
+    size_t capacity_;
+};
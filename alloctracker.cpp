@@ -0,0 +1,417 @@
+#include "alloctracker.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <new>
+#include <string>
+#include <vector>
+
+#if defined(__GLIBC__)
+#include <cxxabi.h>
+#include <execinfo.h>
+#define SWR_ALLOC_SITES
+#define SWR_NOINLINE __attribute__((noinline))
+#else
+#define SWR_NOINLINE
+#endif
+
+#define LOG_MODULE_NAME ("AllocTracker")
+#include "log.hpp"
+
+namespace
+{
+    // Return addresses kept per site, after dropping recordSite(), count(),
+    // allocate() and operator new. None of them may be inlined or end in a
+    // tail call, or the wrong frames are dropped.
+    constexpr int DEPTH = 8;
+    constexpr int SKIP = 4;
+    // Fixed, so recording a site never allocates.
+    constexpr int SITE_COUNT = 4096;
+    constexpr int NAME_LENGTH = 100;
+
+    struct Site
+    {
+        const char *tag;
+        void *frames[DEPTH];
+        int depth;
+        long long allocations;
+        long long bytes;
+    };
+
+    std::atomic<long long> allocations(0);
+    std::atomic<long long> bytes(0);
+    std::atomic<const char *> current_tag(nullptr);
+    std::atomic<bool> sites_enabled(false);
+
+    std::atomic_flag sites_lock = ATOMIC_FLAG_INIT;
+    Site sites[SITE_COUNT];
+    long long dropped_allocations = 0;
+    long long dropped_bytes = 0;
+
+#ifdef SWR_ALLOC_SITES
+#ifdef SWR_ALLOC_TRACKING
+    // Set while a thread records a site, so anything backtrace() allocates
+    // is counted but not recorded in turn.
+    thread_local bool recording = false;
+
+    SWR_NOINLINE void recordSite(size_t size)
+    {
+        if (recording)
+            return;
+        recording = true;
+
+        void *frames[DEPTH + SKIP];
+        const int captured = backtrace(frames, DEPTH + SKIP);
+        const int depth = std::max(0, captured - SKIP);
+        const char *tag = current_tag.load(std::memory_order_relaxed);
+
+        // FNV-1a over the tag and the return addresses.
+        uint64_t hash = 14695981039346656037ull;
+        auto mix = [&hash](uintptr_t value)
+        {
+            hash ^= value;
+            hash *= 1099511628211ull;
+        };
+        mix((uintptr_t)tag);
+        for (int i = 0; i < depth; i++)
+            mix((uintptr_t)frames[SKIP + i]);
+
+        while (sites_lock.test_and_set(std::memory_order_acquire))
+        {
+        }
+
+        // Linear probing; a full table drops the site into the remainder.
+        bool found = false;
+        for (int probe = 0; probe < SITE_COUNT && !found; probe++)
+        {
+            Site &site = sites[(hash + probe) % SITE_COUNT];
+            if (site.allocations == 0)
+            {
+                site.tag = tag;
+                site.depth = depth;
+                std::memcpy(site.frames, frames + SKIP, depth * sizeof(void *));
+            }
+            else if (site.tag != tag ||
+                site.depth != depth ||
+                std::memcmp(site.frames, frames + SKIP, depth * sizeof(void *)) != 0)
+            {
+                continue;
+            }
+            site.allocations++;
+            site.bytes += size;
+            found = true;
+        }
+        if (!found)
+        {
+            dropped_allocations++;
+            dropped_bytes += size;
+        }
+
+        sites_lock.clear(std::memory_order_release);
+        recording = false;
+    }
+#endif
+
+    // The function name in a backtrace_symbols() line, demangled and cut
+    // short, or the whole line when it has none.
+    std::string getFunctionName(const char *symbol)
+    {
+        std::string line(symbol);
+        const size_t open = line.find('(');
+        const size_t plus = line.find('+', open);
+        if (open == std::string::npos || plus == std::string::npos || plus == open + 1)
+            return line;
+
+        std::string name = line.substr(open + 1, plus - open - 1);
+        int status = 0;
+        char *demangled = abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status);
+        if (demangled)
+        {
+            if (status == 0)
+                name = demangled;
+            std::free(demangled);
+        }
+        if (name.size() > NAME_LENGTH)
+            name = name.substr(0, NAME_LENGTH - 3) + "...";
+        return name;
+    }
+#endif
+}
+
+bool AllocTracker::isEnabled()
+{
+#ifdef SWR_ALLOC_TRACKING
+    return true;
+#else
+    return false;
+#endif
+}
+
+void AllocTracker::read(Counts &counts)
+{
+    counts.allocations = allocations.load(std::memory_order_relaxed);
+    counts.bytes = bytes.load(std::memory_order_relaxed);
+}
+
+void AllocTracker::setTag(const char *name)
+{
+    current_tag.store(name, std::memory_order_relaxed);
+}
+
+void AllocTracker::enableSites()
+{
+#ifdef SWR_ALLOC_SITES
+    // The first backtrace() loads the unwinder, which allocates; get that
+    // out of the way before any site is recorded.
+    void *frames[DEPTH];
+    backtrace(frames, DEPTH);
+    sites_enabled = true;
+#else
+    LOG_WARNING << "Failure in recording allocation call sites, not supported on this platform." << std::endl;
+#endif
+}
+
+void AllocTracker::disableSites()
+{
+    sites_enabled = false;
+}
+
+void AllocTracker::clearSites()
+{
+    while (sites_lock.test_and_set(std::memory_order_acquire))
+    {
+    }
+    for (Site &site : sites)
+        site = Site();
+    dropped_allocations = 0;
+    dropped_bytes = 0;
+    sites_lock.clear(std::memory_order_release);
+}
+
+void AllocTracker::writeSites(std::ostream &out, int top)
+{
+#ifdef SWR_ALLOC_SITES
+    // Copied out under the lock; symbolizing allocates, and may record
+    // sites of its own if they are still enabled.
+    std::vector<Site> used;
+    used.reserve(SITE_COUNT);
+    while (sites_lock.test_and_set(std::memory_order_acquire))
+    {
+    }
+    for (const Site &site : sites)
+        if (site.allocations > 0)
+            used.push_back(site);
+    const long long dropped = dropped_allocations;
+    const long long dropped_size = dropped_bytes;
+    sites_lock.clear(std::memory_order_release);
+
+    std::sort(used.begin(), used.end(), [](const Site &a, const Site &b)
+    {
+        return a.allocations > b.allocations;
+    });
+
+    long long rest = 0;
+    long long rest_bytes = 0;
+    for (int i = 0; i < (int)used.size(); i++)
+    {
+        const Site &site = used[i];
+        if (i >= top)
+        {
+            rest += site.allocations;
+            rest_bytes += site.bytes;
+            continue;
+        }
+
+        out << "#" << std::left << std::setw(4) << i + 1 << std::right
+            << std::setw(10) << site.allocations << " allocations"
+            << std::setw(14) << site.bytes << " bytes"
+            << "  [" << (site.tag ? site.tag : "untagged") << "]\n";
+        char **symbols = backtrace_symbols(site.frames, site.depth);
+        for (int j = 0; j < site.depth; j++)
+        {
+            out << "      " << site.frames[j] << " ";
+            out << (symbols ? getFunctionName(symbols[j]) : std::string("?")) << "\n";
+        }
+        std::free(symbols);
+    }
+    if (rest > 0)
+        out << "      " << rest << " allocations, " << rest_bytes << " bytes in "
+            << used.size() - top << " more sites\n";
+    if (dropped > 0)
+        out << "      " << dropped << " allocations, " << dropped_size
+            << " bytes at sites that did not fit in the table\n";
+#else
+    out << "Allocation call sites are not supported on this platform.\n";
+#endif
+}
+
+#ifdef SWR_ALLOC_TRACKING
+
+// Replacements for every global form of operator new and delete. Each
+// allocation is counted before it is made; frees are not counted. The
+// aligned forms only exist from C++17 on.
+
+namespace
+{
+    SWR_NOINLINE void count(size_t size)
+    {
+#ifdef SWR_ALLOC_SITES
+        if (sites_enabled.load(std::memory_order_relaxed))
+            recordSite(size);
+#endif
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        bytes.fetch_add((long long)size, std::memory_order_relaxed);
+    }
+
+    SWR_NOINLINE void *allocate(size_t size)
+    {
+        count(size);
+        return std::malloc(size ? size : 1);
+    }
+
+#ifdef __cpp_aligned_new
+    SWR_NOINLINE void *allocateAligned(size_t size, size_t alignment)
+    {
+        count(size);
+#ifdef _WIN32
+        return _aligned_malloc(size ? size : 1, alignment);
+#else
+        void *pointer = nullptr;
+        if (posix_memalign(&pointer, std::max(alignment, sizeof(void *)), size ? size : 1) != 0)
+            return nullptr;
+        return pointer;
+#endif
+    }
+
+    void freeAligned(void *pointer)
+    {
+#ifdef _WIN32
+        _aligned_free(pointer);
+#else
+        std::free(pointer);
+#endif
+    }
+#endif
+}
+
+void *operator new(size_t size)
+{
+    void *pointer = allocate(size);
+    if (!pointer)
+        throw std::bad_alloc();
+    return pointer;
+}
+
+void *operator new[](size_t size)
+{
+    void *pointer = allocate(size);
+    if (!pointer)
+        throw std::bad_alloc();
+    return pointer;
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    return allocate(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+    return allocate(size);
+}
+
+#ifdef __cpp_aligned_new
+void *operator new(size_t size, std::align_val_t alignment)
+{
+    void *pointer = allocateAligned(size, (size_t)alignment);
+    if (!pointer)
+        throw std::bad_alloc();
+    return pointer;
+}
+
+void *operator new[](size_t size, std::align_val_t alignment)
+{
+    void *pointer = allocateAligned(size, (size_t)alignment);
+    if (!pointer)
+        throw std::bad_alloc();
+    return pointer;
+}
+
+void *operator new(size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return allocateAligned(size, (size_t)alignment);
+}
+
+void *operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return allocateAligned(size, (size_t)alignment);
+}
+#endif
+
+void operator delete(void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer, size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, const std::nothrow_t &) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer, const std::nothrow_t &) noexcept
+{
+    std::free(pointer);
+}
+
+#ifdef __cpp_aligned_new
+void operator delete(void *pointer, std::align_val_t) noexcept
+{
+    freeAligned(pointer);
+}
+
+void operator delete[](void *pointer, std::align_val_t) noexcept
+{
+    freeAligned(pointer);
+}
+
+void operator delete(void *pointer, size_t, std::align_val_t) noexcept
+{
+    freeAligned(pointer);
+}
+
+void operator delete[](void *pointer, size_t, std::align_val_t) noexcept
+{
+    freeAligned(pointer);
+}
+
+void operator delete(void *pointer, std::align_val_t, const std::nothrow_t &) noexcept
+{
+    freeAligned(pointer);
+}
+
+void operator delete[](void *pointer, std::align_val_t, const std::nothrow_t &) noexcept
+{
+    freeAligned(pointer);
+}
+#endif
+
+#endif
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <ostream>
+
+// Counts heap allocations made through operator new, by every thread, for
+// finding and keeping out allocations in the per-frame path. Compiled in
+// only with SWR_ALLOC_TRACKING (cmake -DSWR_ALLOC_TRACKING=ON), which
+// replaces the global operator new and delete; otherwise the counts stay
+// zero and nothing is hooked. malloc() called directly, by C libraries and
+// drivers, is not seen.
+//
+// Counting is two relaxed atomic adds per allocation. Call sites are
+// recorded only between enableSites() and disableSites(): each allocation
+// then takes a backtrace and a short spinlock on a fixed table, so expect
+// frames to slow down a lot.
+class AllocTracker
+{
+public:
+    struct Counts
+    {
+        Counts() :
+            allocations(0),
+            bytes(0)
+        {
+        }
+
+        Counts &operator+=(const Counts &rhs)
+        {
+            allocations += rhs.allocations;
+            bytes += rhs.bytes;
+            return *this;
+        }
+
+        Counts operator-(const Counts &rhs) const
+        {
+            Counts result;
+            result.allocations = allocations - rhs.allocations;
+            result.bytes = bytes - rhs.bytes;
+            return result;
+        }
+
+        long long allocations;
+        long long bytes;
+    };
+
+    // Whether the hooks are compiled in.
+    static bool isEnabled();
+
+    // Totals since the start of the process; take differences of two reads
+    // for a frame or a stage.
+    static void read(Counts &counts);
+
+    // Names what is running, e.g. a pipeline stage; recorded call sites are
+    // told apart by it. name must outlive the tracker; string literals do.
+    // Applies to every thread, so allocations on the pool count towards
+    // the stage the rendering thread set.
+    static void setTag(const char *name);
+
+    static void enableSites();
+
+    static void disableSites();
+
+    // Forgets the recorded call sites.
+    static void clearSites();
+
+    // The top call sites by allocation count, one symbolized backtrace
+    // each. Sites that did not fit in the table are summed up at the end.
+    static void writeSites(std::ostream &out, int top);
+};
@@ -1,22 +1,38 @@
 #include "app.hpp"
 
 #include <chrono>
+#include <cstdio>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <SDL.h>
 #include <SDL_render.h>
+#include <algorithm>
+#include <deque>
 #include <limits>
 #include <memory>
 #include <functional>
 
+#include "alloctracker.hpp"
 #include "camera.hpp"
-#include "mesh.hpp"
+#include "camerapath.hpp"
+#include "demoscene.hpp"
+#include "framepacer.hpp"
+#include "framepipeline.hpp"
+#include "model.hpp"
+#include "perfcounters.hpp"
+#include "profiler.hpp"
+#include "renderer.hpp"
+#include "resolutioncontroller.hpp"
+#include "scene.hpp"
+#include "sdlframebuffer.hpp"
 #include "sdlwindow.hpp"
 #include "sdlrenderer.hpp"
 #include "sdltexture.hpp"
-#include "triangle.hpp"
+#include "tilemask.hpp"
 #include "gamecontroller.hpp"
-#include "teapot.hpp"
+#include "hud.hpp"
+#include "threadpool.hpp"
+#include "trace.hpp"
 
 #define LOG_MODULE_NAME ("App")
 #include "log.hpp"
@@ -31,36 +47,8 @@ App::~App()
     SDL_Quit();
 }
 
-void inline triangle2(
-    const glm::dvec3& a,
-    const glm::dvec3& b,
-    const glm::dvec3& c,
-    std::function<void(int x, int y, double z)> dotproc)
-{
-    triangle(
-        a.x, a.y, a.z,
-        b.x, b.y, b.z,
-        c.x, c.y, c.z,
-        dotproc);
-}
-
-void xform(const glm::dmat3& m, std::vector<glm::dvec3> &ns)
-{
-    for (auto& n : ns)
-        n = m * n;
-    ns.push_back(glm::dvec3(0.0, 0.0, 0.0));
-}
-
-void xform(const glm::dmat4& m, std::vector<glm::dvec4>& vs)
-{
-    for (auto& v : vs)
-        v = m * v;
-}
-
 void App::run(const std::vector<std::string> &args)
 {
-    init();
-
     bool run = true;
     int ellapsed = 0;
 
@@ -72,34 +60,286 @@ void App::run(const std::vector<std::string> &args)
 
     int mouse_button = 0;
 
-    Mesh mesh;
+    int grid = 1;
+    bool occlusion = false;
+    bool serial = false;
+    bool continuous = false;
+    bool hud_visible = false;
+    bool perf = false;
+    Renderer::DebugView debug_view = Renderer::DebugView::NONE;
+    double frame_budget = 0.0;
+    double min_scale = 0.5;
+    double max_scale = 1.0;
+    FramePacer::Mode pacing = FramePacer::Mode::VSYNC;
+    double rate = 0.0;
+    std::string profile_path;
+    std::string trace_path;
+    std::string record_path;
+    std::string play_path;
+    for (int i = 1; i < (int)args.size(); i++)
     {
-        int triangle_count = teapot_indices.size() / 3;
-        for (int i = 0; i < triangle_count; i++)
+        if (args[i] == "--grid" && i + 1 < (int)args.size())
+            grid = std::max(1, std::stoi(args[++i]));
+        else if (args[i] == "--occlusion")
+            occlusion = true;
+        else if (args[i] == "--serial")
+            serial = true;
+        else if (args[i] == "--continuous")
+            continuous = true;
+        else if (args[i] == "--hud")
+            hud_visible = true;
+        else if (args[i] == "--perf")
+            perf = true;
+        else if (args[i] == "--pacing" && i + 1 < (int)args.size())
         {
-            int index = 3 * i;
-            mesh.addTriangle(
-                mesh.addVertex(glm::dvec3(
-                    teapot_vertices[3 * (teapot_indices[index + 0]) + 0],
-                    teapot_vertices[3 * (teapot_indices[index + 0]) + 1],
-                    teapot_vertices[3 * (teapot_indices[index + 0]) + 2])),
-                mesh.addVertex(glm::dvec3(
-                    teapot_vertices[3 * (teapot_indices[index + 1]) + 0],
-                    teapot_vertices[3 * (teapot_indices[index + 1]) + 1],
-                    teapot_vertices[3 * (teapot_indices[index + 1]) + 2])),
-                mesh.addVertex(glm::dvec3(
-                    teapot_vertices[3 * (teapot_indices[index + 2]) + 0],
-                    teapot_vertices[3 * (teapot_indices[index + 2]) + 1],
-                    teapot_vertices[3 * (teapot_indices[index + 2]) + 2])),
-                glm::dvec3(1.0, 1.0, 1.0));
+            if (!FramePacer::parseMode(args[++i], pacing))
+            {
+                LOG_ERROR << "Failure in --pacing, expected vsync, uncapped, fixed or adaptive. (" << args[i] << ")" << std::endl;
+                throw std::exception();
+            }
+        }
+        else if (args[i] == "--debug-view" && i + 1 < (int)args.size())
+        {
+            if (!Renderer::parseDebugView(args[++i], debug_view))
+            {
+                LOG_ERROR << "Failure in --debug-view, expected none, overdraw, depthfail or tiletime. (" << args[i] << ")" << std::endl;
+                throw std::exception();
+            }
+        }
+        else if (args[i] == "--rate" && i + 1 < (int)args.size())
+            rate = std::stod(args[++i]);
+        else if (args[i] == "--profile" && i + 1 < (int)args.size())
+            profile_path = args[++i];
+        else if (args[i] == "--trace" && i + 1 < (int)args.size())
+            trace_path = args[++i];
+        else if (args[i] == "--record-path" && i + 1 < (int)args.size())
+            record_path = args[++i];
+        else if (args[i] == "--play-path" && i + 1 < (int)args.size())
+            play_path = args[++i];
+        else if (args[i] == "--frame-budget" && i + 1 < (int)args.size())
+            frame_budget = std::stod(args[++i]);
+        else if (args[i] == "--scale-range" && i + 1 < (int)args.size())
+        {
+            const std::string range = args[++i];
+            const size_t colon = range.find(':');
+            if (colon == std::string::npos)
+            {
+                LOG_ERROR << "Failure in --scale-range, expected MIN:MAX. (" << range << ")" << std::endl;
+                throw std::exception();
+            }
+            min_scale = std::stod(range.substr(0, colon));
+            max_scale = std::stod(range.substr(colon + 1));
         }
     }
 
-    constexpr double RAD = glm::pi<double>() / 180.0;
-    constexpr glm::dmat4 identity = glm::identity<glm::dmat4>();
+#ifndef SWR_TRACE
+    if (!trace_path.empty())
+        LOG_WARNING << "Tracing is not compiled in, --trace ignored. Build with -DSWR_TRACE=ON." << std::endl;
+#endif
+    TRACE_THREAD_NAME("main");
+    // Counters go into the profile, next to the stage times.
+    if (perf)
+        PerfCounters::open();
 
-    std::vector<double> depth;
-    depth.resize(sdl_texture_->getWidth()* sdl_texture_->getHeight());
+    init(pacing == FramePacer::Mode::VSYNC);
+
+    if (rate <= 0.0)
+    {
+        // Default to the display refresh rate.
+        SDL_DisplayMode mode;
+        rate = SDL_GetDesktopDisplayMode(0, &mode) == 0 && mode.refresh_rate > 0 ?
+            mode.refresh_rate :
+            60.0;
+    }
+    FramePacer pacer(pacing, rate);
+
+    // The internal resolution follows the controller. The framebuffer grows
+    // as needed and SDL_RenderCopy stretches whatever part of it holds the
+    // frame over the window.
+    ResolutionController resolution(frame_budget, min_scale, frame_budget > 0.0 ? max_scale : 1.0);
+    int window_width = sdl_window_->getDefaultResolution().first;
+    int window_height = sdl_window_->getDefaultResolution().second;
+    {
+        const glm::ivec2 size = resolution.getMaxSize(window_width, window_height);
+        sdl_framebuffer_ = std::make_shared<SDLFramebuffer>(sdl_renderer_, size.x, size.y);
+    }
+    SDL_Rect shown = sdl_framebuffer_->getRect();
+
+    // The texture holds the pipeline frame with this number; the next one
+    // only needs its damaged tiles uploaded.
+    long long uploaded_frame = -1;
+    const SDLTexture* uploaded_texture = nullptr;
+    std::vector<TileMask::Rect> upload_rects;
+    double uploaded_bytes = 0.0;
+
+    Scene scene;
+    auto model = buildTeapotScene(scene, grid, occlusion);
+    const int scene_triangles =
+        scene.getObjectCount() * (model->getLodChain().getLevel(0).getIndices().size() / 3);
+    std::string reported_title;
+
+    Renderer renderer(thread_pool_);
+    renderer.setOcclusion(occlusion);
+    bool occlusion_debug = false;
+
+    // Renders on its own thread unless --serial asks for the old loop that
+    // renders straight into the locked texture and then presents.
+    std::unique_ptr<FramePipeline> pipeline;
+    if (!serial)
+        pipeline = std::make_unique<FramePipeline>(renderer, scene);
+
+    Renderer::Stats stats = {};
+    double render_ms = 0.0;
+    double latency_ms = 0.0;
+    int presented = 0;
+    int report_start = SDL_GetTicks();
+    std::string timing;
+
+    // Always on. P writes the profile out, and so does quitting when
+    // --profile gave a path prefix.
+    Profiler profiler;
+    auto writeProfile = [&profiler, &profile_path]()
+    {
+        const std::string prefix = profile_path.empty() ? "profile" : profile_path;
+        profiler.writeCsv(prefix + ".csv");
+        profiler.writeJson(prefix + ".json");
+        LOG_INFO << "Profile written. (" << prefix << ".csv, " << prefix << ".json)" << std::endl;
+    };
+    auto recordStats = [&profiler](const Renderer::Stats &stats)
+    {
+        profiler.record(Profiler::CULL, stats.cull_ms);
+        profiler.record(Profiler::TRANSFORM, stats.transform_ms);
+        profiler.record(Profiler::CLIP, stats.clip_ms);
+        profiler.record(Profiler::CLEAR, stats.clear_ms);
+        profiler.record(Profiler::RASTERIZE, stats.rasterize_ms);
+        if (PerfCounters::isOpen())
+        {
+            const long long triangles = stats.pipeline.input_triangles;
+            profiler.recordCounters(Profiler::CULL, stats.cull_counters, triangles);
+            profiler.recordCounters(Profiler::TRANSFORM, stats.transform_counters, triangles);
+            profiler.recordCounters(Profiler::CLIP, stats.clip_counters, triangles);
+            profiler.recordCounters(Profiler::CLEAR, stats.clear_counters, stats.pipeline.cleared_pixels);
+            profiler.recordCounters(Profiler::RASTERIZE, stats.rasterize_counters, stats.pipeline.fragments);
+        }
+        if (AllocTracker::isEnabled())
+        {
+            profiler.recordAllocations(Profiler::CULL, stats.cull_allocations);
+            profiler.recordAllocations(Profiler::TRANSFORM, stats.transform_allocations);
+            profiler.recordAllocations(Profiler::CLIP, stats.clip_allocations);
+            profiler.recordAllocations(Profiler::CLEAR, stats.clear_allocations);
+            profiler.recordAllocations(Profiler::RASTERIZE, stats.rasterize_allocations);
+        }
+    };
+
+    // Input to photon latency. Camera input is stamped with the time SDL
+    // received it; SDL stamps events in SDL_GetTicks() milliseconds, carried
+    // over to the steady clock by their age. Each submitted frame that is
+    // the first to reflect new input is queued with the oldest event in it.
+    // Presenting a frame records the latency of the oldest queued input up
+    // to it, since a frame also reflects the input of frames the pipeline
+    // skipped.
+    struct PendingInput
+    {
+        long long sequence;
+        Profiler::Clock::time_point time;
+    };
+    std::deque<PendingInput> pending_inputs;
+    bool has_input = false;
+    Profiler::Clock::time_point input_time;
+    auto stampInput = [&has_input, &input_time](const SDL_Event &e)
+    {
+        if (has_input)
+            return;
+        has_input = true;
+        input_time = Profiler::Clock::now() - std::chrono::milliseconds(SDL_GetTicks() - e.common.timestamp);
+    };
+    auto recordLatency = [&profiler, &pending_inputs](long long sequence)
+    {
+        if (pending_inputs.empty() || pending_inputs.front().sequence > sequence)
+            return;
+        const Profiler::Clock::time_point oldest = pending_inputs.front().time;
+        while (!pending_inputs.empty() && pending_inputs.front().sequence <= sequence)
+            pending_inputs.pop_front();
+        const double ms = std::chrono::duration<double, std::milli>(Profiler::Clock::now() - oldest).count();
+        profiler.record(Profiler::LATENCY, ms);
+        TRACE_COUNTER("input latency", ms);
+    };
+
+    // Pipeline counters of the last frame, toggled with H.
+    Hud hud(sdl_renderer_);
+    auto updateHud = [&hud, &profiler](const Renderer::Stats &stats)
+    {
+        const PipelineStats &p = stats.pipeline;
+        const Profiler::Summary frame_summary = profiler.getSummary(Profiler::FRAME);
+        char buffer[128];
+        std::vector<std::string> lines;
+        snprintf(buffer, sizeof(buffer), "OBJECTS %d TILES %d/%d",
+            stats.visible_objects, stats.redrawn_tiles, stats.tile_count);
+        lines.push_back(buffer);
+        snprintf(buffer, sizeof(buffer), "TRIANGLES IN %lld BACKFACE %lld REJECTED %lld",
+            p.input_triangles, p.backfaces, p.rejected_triangles);
+        lines.push_back(buffer);
+        snprintf(buffer, sizeof(buffer), "CLIPPED %lld OUT %lld",
+            p.clipped_triangles, p.emitted_triangles);
+        lines.push_back(buffer);
+        snprintf(buffer, sizeof(buffer), "FRAGMENTS %lld DEPTH PASS %lld FAIL %lld",
+            p.fragments, p.depth_passed, p.depth_failed);
+        lines.push_back(buffer);
+        snprintf(buffer, sizeof(buffer), "WRITTEN %lld PIXELS", p.written_pixels);
+        lines.push_back(buffer);
+        snprintf(buffer, sizeof(buffer), "RASTER %.2f MS FRAME P50 %.2f P95 %.2f MS",
+            stats.raster_ms, frame_summary.p50_ms, frame_summary.p95_ms);
+        lines.push_back(buffer);
+        const Profiler::Summary latency_summary = profiler.getSummary(Profiler::LATENCY);
+        if (latency_summary.count > 0)
+        {
+            snprintf(buffer, sizeof(buffer), "INPUT LATENCY P50 %.2f P95 %.2f P99 %.2f MS",
+                latency_summary.p50_ms, latency_summary.p95_ms, latency_summary.p99_ms);
+            lines.push_back(buffer);
+        }
+        if (PerfCounters::isAvailable(PerfCounters::INSTRUCTIONS))
+        {
+            auto ipc = [](const PerfCounters::Sample &sample)
+            {
+                const uint64_t cycles = sample.values[PerfCounters::CYCLES];
+                return cycles ? (double)sample.values[PerfCounters::INSTRUCTIONS] / cycles : 0.0;
+            };
+            snprintf(buffer, sizeof(buffer), "IPC CLIP %.2f RASTERIZE %.2f",
+                ipc(stats.clip_counters), ipc(stats.rasterize_counters));
+            lines.push_back(buffer);
+        }
+        hud.setLines(lines);
+    };
+    // The HUD goes over the frame, not into it, so the frame texture keeps
+    // exactly what the renderer wrote.
+    auto present = [this, &shown, &hud, &hud_visible]()
+    {
+        sdl_renderer_->renderCopy(sdl_framebuffer_->getTexture(), &shown);
+        if (hud_visible)
+            hud.render();
+        sdl_renderer_->renderPresent();
+    };
+
+    // --record-path saves the view of every rendered frame on exit.
+    // --play-path renders the views of a recorded path instead of the
+    // camera's, each one once and in order, then quits; the profile holds
+    // the frame times.
+    CameraPath recorded_path;
+    CameraPath played_path;
+    int played_frames = 0;
+    if (!play_path.empty())
+        played_path.load(play_path);
+    const bool playing = played_path.getFrameCount() > 0;
+
+    // Render on demand: a frame is only produced when the camera, the scene,
+    // the window or a view option changed since the last one. Otherwise the
+    // loop sleeps in SDL_WaitEventTimeout. --continuous renders every frame.
+    bool dirty = true;
+    bool idle = false;
+    bool in_flight = false;
+    long long sequence = 0;
+    unsigned int camera_version = camera_->getVersion();
+    unsigned int scene_version = scene.getVersion();
 
     {
         int res = SDL_GameControllerAddMappingsFromFile("gamecontrollerdb.txt");
@@ -128,7 +368,14 @@ void App::run(const std::vector<std::string> &args)
         int frame_start = SDL_GetTicks();
 
         SDL_Event e;
-        while (SDL_PollEvent(&e))
+        bool has_event = idle ?
+            SDL_WaitEventTimeout(&e, IDLE_TIMEOUT) == 1 :
+            SDL_PollEvent(&e) == 1;
+
+        // Time spent asleep waiting for input is not part of the frame.
+        profiler.beginFrame();
+        const Profiler::Clock::time_point events_start = Profiler::Clock::now();
+        for (; has_event; has_event = SDL_PollEvent(&e) == 1)
         {
             for (auto& game_controller : game_controllers_)
                 game_controller.second->handleEvent(e);
@@ -146,22 +393,67 @@ void App::run(const std::vector<std::string> &args)
                 break;
             case SDL_MOUSEMOTION:
                 if (mouse_button == 3)
+                {
                     camera_->rotate(e.motion.xrel, e.motion.yrel);
+                    stampInput(e);
+                }
                 else if (mouse_button == 2)
+                {
                     camera_->pan(e.motion.xrel, e.motion.yrel);
+                    stampInput(e);
+                }
+                break;
+            case SDL_KEYDOWN:
+                if (e.key.keysym.sym == SDLK_o)
+                {
+                    occlusion_debug = !occlusion_debug;
+                    dirty = true;
+                }
+                else if (e.key.keysym.sym == SDLK_p)
+                {
+                    // A profile that cannot be written is not worth ending
+                    // the session over; the one on exit still throws.
+                    try
+                    {
+                        writeProfile();
+                    }
+                    catch (const std::exception &)
+                    {
+                        LOG_ERROR << "Failure in writing profile, session continues." << std::endl;
+                    }
+                }
+                else if (e.key.keysym.sym == SDLK_v)
+                {
+                    // Cycles through the heatmaps and back to shading.
+                    debug_view = debug_view == Renderer::DebugView::TILE_TIME ?
+                        Renderer::DebugView::NONE :
+                        (Renderer::DebugView)((int)debug_view + 1);
+                    LOG_INFO << "Debug view changed. (" << Renderer::getDebugViewName(debug_view) << ")" << std::endl;
+                    dirty = true;
+                }
+                else if (e.key.keysym.sym == SDLK_h)
+                {
+                    hud_visible = !hud_visible;
+                    dirty = true;
+                }
                 break;
             case SDL_MOUSEWHEEL:
                 camera_->zoom(e.wheel.preciseY);
+                stampInput(e);
+                break;
+            case SDL_CONTROLLERAXISMOTION:
+            case SDL_CONTROLLERBUTTONDOWN:
+                // Moves the camera below, from the controller's state.
+                stampInput(e);
                 break;
             case SDL_WINDOWEVENT:
+                // Drag resizing sends these in bursts; only the last size
+                // is used, when the next frame is set up below.
                 if (e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)
                 {
-                    sdl_texture_ = std::make_shared<SDLTexture>(
-                        sdl_renderer_,
-                        SDL_TEXTUREACCESS_STREAMING,
-                        e.window.data1,
-                        e.window.data2);
-                    depth.resize(sdl_texture_->getWidth() * sdl_texture_->getHeight());
+                    window_width = e.window.data1;
+                    window_height = e.window.data2;
+                    dirty = true;
                 }
                 break;
             case SDL_CONTROLLERDEVICEADDED:
@@ -174,8 +466,10 @@ void App::run(const std::vector<std::string> &args)
                 break;
             }
         }
+        profiler.record(Profiler::EVENTS, events_start);
 
         {
+            Profiler::Scope scope(profiler, Profiler::CONTROLLERS);
             glm::dvec2 left_stick(0.0);
             glm::dvec2 right_stick(0.0);
             double pan_z = 0.0;
@@ -212,85 +506,287 @@ void App::run(const std::vector<std::string> &args)
             camera_->zoom(-left_stick.y / 8.0);
         }
 
-        sdl_texture_->clear();
+        // Input that left the camera as it was, e.g. a stick inside its
+        // dead zone, has nothing to show.
+        if (has_input && (playing || camera_->getVersion() == camera_version))
+            has_input = false;
 
-        int width = sdl_texture_->getWidth();
-        int height = sdl_texture_->getHeight();
-        unsigned char* pixels = sdl_texture_->getPixels();
-        auto ai = std::chrono::steady_clock::now();
-
-        const glm::dmat4 viewport(
-            width / 2.0, 0.0, 0.0, 0.0,
-            0.0, height / 2.0, 0.0, 0.0,
-            0.0, 0.0, 10.0, 0.0,
-            (width - 1) / 2.0, (height - 1) / 2.0, 0.0, 1.0);
-        const glm::dmat4 projection =
-            glm::perspective(27.0 * RAD, (double)width / (double)height, 0.1, 400.0);
-
-        Mesh current = mesh;
-        current *= camera_->get();
-        current.clip(projection, viewport);
-
-        for (auto& d : depth)
-            d = std::numeric_limits<double>::max();
-
-        int triangle_count = current.getIndices().size() / 3;
-        for (int i = 0; i < triangle_count; i++)
+        if (camera_->getVersion() != camera_version ||
+            scene.getVersion() != scene_version ||
+            continuous)
         {
-            const int index = 3 * i;
-            const glm::dvec4& a = current.getVertices()[current.getIndices()[index + 0]];
-            const glm::dvec4& b = current.getVertices()[current.getIndices()[index + 1]];
-            const glm::dvec4& c = current.getVertices()[current.getIndices()[index + 2]];
-            const glm::dvec3& n = current.getNormals()[i];
-            triangle2(
-                a,
-                b,
-                c,
-                [width, height, pixels, i, &depth, &n](int x, int y, double z)
-                {
-                    if (z <= depth[x + y * width])
-                    {
-                        depth[x + y * width] = z;
-                        y = height - 1 - y;
-                        int idx = 4 * (x + y * width);
-                        double l = glm::mix(
-                            0.2,
-                            1.0,
-                            glm::max(0.0, glm::dot(n, glm::dvec3(0.0, 0.0, 1.0))));
-                        /*
-                        pixels[idx + 1] = ((i + 0) % 3) == 0 ? 255 * l : 0;
-                        pixels[idx + 2] = ((i + 1) % 3) == 0 ? 255 * l : 0;
-                        pixels[idx + 3] = ((i + 2) % 3) == 0 ? 255 * l : 0;
-                        */
-                        pixels[idx + 1] = 255 * l;
-                        pixels[idx + 2] = 255 * l;
-                        pixels[idx + 3] = 255 * l;
-                    }
-                });
+            camera_version = camera_->getVersion();
+            scene_version = scene.getVersion();
+            dirty = true;
         }
+        // A played frame waits for the previous one to be presented, so
+        // the pipeline never drops one.
+        if (playing)
+            dirty = !in_flight;
+        if (idle && dirty)
+            pacer.restart();
+
+        const glm::ivec2 internal = resolution.getSize(window_width, window_height);
+        sdl_framebuffer_->setSize(internal.x, internal.y);
+
+        FramePipeline::Input input;
+        input.view = playing ?
+            played_path.getView(std::min(played_frames, played_path.getFrameCount() - 1)) :
+            camera_->get();
+        input.width = sdl_framebuffer_->getWidth();
+        input.height = sdl_framebuffer_->getHeight();
+        input.format = sdl_renderer_->getPixelFormat();
+        input.occlusion_debug = occlusion_debug;
+        input.debug_view = debug_view;
+        input.sampled = FramePipeline::Clock::now();
+        input.sequence = sequence;
+
+        const int presented_before = presented;
+        if (dirty)
+        {
+            if (!record_path.empty())
+                recorded_path.add(input.view);
+            if (playing)
+                played_frames++;
+            if (has_input)
+            {
+                pending_inputs.push_back(PendingInput{ input.sequence, input_time });
+                has_input = false;
+            }
+        }
+        if (pipeline)
+        {
+            if (dirty)
+            {
+                pipeline->submit(input);
+                sequence++;
+                in_flight = true;
+                dirty = false;
+            }
 
-        auto bi = std::chrono::steady_clock::now();
+            // The texture only grows, so frames rendered for an older window
+            // size still fit and are shown stretched until the next one.
+            const FramePipeline::Frame* frame = pipeline->acquire();
+            if (frame && frame->input.sequence == sequence - 1)
+                in_flight = false;
+            if (frame)
+            {
+                const auto& texture = sdl_framebuffer_->getTexture();
+                const bool partial =
+                    frame->number == uploaded_frame + 1 &&
+                    texture.get() == uploaded_texture &&
+                    frame->framebuffer->getWidth() == shown.w &&
+                    frame->framebuffer->getHeight() == shown.h;
+
+                shown.w = frame->framebuffer->getWidth();
+                shown.h = frame->framebuffer->getHeight();
+                upload_rects.clear();
+                if (partial)
+                    frame->damage.getRects(upload_rects);
+                else
+                    upload_rects.push_back(TileMask::Rect{ 0, 0, shown.w, shown.h });
+                const Profiler::Clock::time_point upload_start = Profiler::Clock::now();
+                for (const TileMask::Rect& r : upload_rects)
+                {
+                    SDL_Rect rect;
+                    rect.x = r.x;
+                    rect.y = r.y;
+                    rect.w = r.width;
+                    rect.h = r.height;
+                    texture->updateTexture(
+                        frame->framebuffer->getPixels(),
+                        frame->framebuffer->getPitch(),
+                        rect);
+                    uploaded_bytes += 4.0 * r.width * r.height;
+                }
+                uploaded_frame = frame->number;
+                uploaded_texture = texture.get();
+                profiler.record(Profiler::UPLOAD, upload_start);
+
+                stats = frame->stats;
+                recordStats(stats);
+                if (hud_visible)
+                    updateHud(stats);
+
+                const Profiler::Clock::time_point present_start = Profiler::Clock::now();
+                present();
+                profiler.record(Profiler::PRESENT, present_start);
+                recordLatency(frame->input.sequence);
+                render_ms += frame->render_ms;
+                latency_ms += std::chrono::duration<double, std::milli>(
+                    FramePipeline::Clock::now() - frame->input.sampled).count();
+                presented++;
+            }
+        }
+        else if (dirty)
+        {
+            renderer.setOcclusionDebug(occlusion_debug);
+            renderer.setDebugView(debug_view);
+            renderer.render(scene, input.view, *sdl_framebuffer_);
+            const auto rendered = FramePipeline::Clock::now();
+
+            stats = renderer.getStats();
+            recordStats(stats);
+            if (hud_visible)
+                updateHud(stats);
+
+            shown = sdl_framebuffer_->getRect();
+            const Profiler::Clock::time_point present_start = Profiler::Clock::now();
+            present();
+            profiler.record(Profiler::PRESENT, present_start);
+            recordLatency(input.sequence);
+            // Locked texture memory goes up whole.
+            uploaded_bytes += 4.0 * shown.w * shown.h;
+
+            // Unlocking the texture is the upload here; it is all of the
+            // raster section that is neither clear nor rasterize.
+            profiler.record(Profiler::UPLOAD, stats.raster_ms - stats.clear_ms - stats.rasterize_ms);
+            render_ms += std::chrono::duration<double, std::milli>(rendered - input.sampled).count();
+            latency_ms += std::chrono::duration<double, std::milli>(
+                FramePipeline::Clock::now() - input.sampled).count();
+            presented++;
+            dirty = false;
+        }
 
-        sdl_texture_->updateTexture();
-        sdl_renderer_->renderCopy(sdl_texture_);
-        sdl_renderer_->renderPresent();
+        if (presented != presented_before)
+        {
+            resolution.update(stats.raster_ms);
+            pacer.pace();
+        }
+        else if (in_flight)
+        {
+            SDL_Delay(1); // Render thread has nothing new yet.
+        }
+        else if (idle)
+        {
+            // Woken up with nothing to render; the window may still need
+            // its contents back, e.g. after being uncovered.
+            present();
+        }
+        idle = !dirty && !in_flight;
+        if (playing && played_frames >= played_path.getFrameCount() && !in_flight)
+            run = false;
+        if (presented != presented_before)
+            profiler.endFrame();
+        else
+            profiler.discardFrame();
 
-        const int MIN_FRAME = 1;
-        int frame_end = SDL_GetTicks();
-        SDL_Delay(std::max(0, MIN_FRAME - (frame_end - frame_start)));
         frame_delay = SDL_GetTicks() - frame_start;
         ellapsed += frame_delay;
 
         frame_count++;
 
-        /*
-        sdl_window_->setWindowTitle(
-            std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(bi - ai).count() / 1000.0));
-        */
+        // Frame rate, render time and input to present latency, averaged
+        // over about a second.
+        if (frame_start - report_start >= 1000 && presented == 0)
+        {
+            timing = " idle";
+            report_start = frame_start;
+        }
+        else if (frame_start - report_start >= 1000)
+        {
+            const FramePacer::Stats& pacing_stats = pacer.getStats();
+            char buffer[192];
+            snprintf(
+                buffer,
+                sizeof(buffer),
+                " fps %.1f render %.1f ms latency %.1f ms %s %.0f Hz/%d jitter %.2f ms late %d",
+                presented * 1000.0 / (frame_start - report_start),
+                render_ms / presented,
+                latency_ms / presented,
+                FramePacer::getModeName(pacer.getMode()),
+                pacer.getRate(),
+                pacer.getDivisor(),
+                pacing_stats.jitter_ms,
+                pacing_stats.late_frames);
+            timing = buffer;
+            snprintf(
+                buffer,
+                sizeof(buffer),
+                " upload %.0f KiB/frame tiles %d/%d",
+                uploaded_bytes / presented / 1024.0,
+                stats.redrawn_tiles,
+                stats.tile_count);
+            timing += buffer;
+            uploaded_bytes = 0.0;
+            const Profiler::Summary frame_summary = profiler.getSummary(Profiler::FRAME);
+            snprintf(
+                buffer,
+                sizeof(buffer),
+                " frame p95 %.1f p99 %.1f ms",
+                frame_summary.p95_ms,
+                frame_summary.p99_ms);
+            timing += buffer;
+            const Profiler::Summary latency_summary = profiler.getSummary(Profiler::LATENCY);
+            if (latency_summary.count > 0)
+            {
+                snprintf(
+                    buffer,
+                    sizeof(buffer),
+                    " input p50 %.1f p95 %.1f ms",
+                    latency_summary.p50_ms,
+                    latency_summary.p95_ms);
+                timing += buffer;
+            }
+            if (resolution.isEnabled())
+            {
+                snprintf(
+                    buffer,
+                    sizeof(buffer),
+                    " scale %.2f (%dx%d)",
+                    resolution.getScale(),
+                    shown.w,
+                    shown.h);
+                timing += buffer;
+            }
+            pacer.resetStats();
+            render_ms = 0.0;
+            latency_ms = 0.0;
+            presented = 0;
+            report_start = frame_start;
+        }
+
+        std::string title =
+            "triangles " + std::to_string(stats.rendered_triangles) +
+            " / " + std::to_string(scene_triangles);
+        if (occlusion)
+        {
+            title +=
+                " occluders " + std::to_string(stats.occlusion.occluders) +
+                " (" + std::to_string(stats.occlusion.occluder_triangles) + " triangles)" +
+                " culled " + std::to_string(stats.occlusion.occludees_culled) +
+                " / " + std::to_string(stats.occlusion.occludees_tested);
+        }
+        if (debug_view != Renderer::DebugView::NONE)
+            title += std::string(" view ") + Renderer::getDebugViewName(debug_view);
+        title += timing;
+        if (title != reported_title)
+        {
+            sdl_window_->setWindowTitle(title);
+            reported_title = title;
+        }
+
+    }
+
+    if (playing)
+    {
+        const Profiler::Summary frame_summary = profiler.getSummary(Profiler::FRAME);
+        LOG_INFO << "Camera path played. (" << played_frames << " frames"
+            << ", p50 " << frame_summary.p50_ms << " ms"
+            << ", p95 " << frame_summary.p95_ms << " ms"
+            << ", p99 " << frame_summary.p99_ms << " ms)" << std::endl;
     }
+    if (!record_path.empty())
+        recorded_path.save(record_path);
+    if (!profile_path.empty())
+        writeProfile();
+#ifdef SWR_TRACE
+    if (!trace_path.empty())
+        Trace::write(trace_path);
+#endif
 }
 
-void App::init()
+void App::init(bool vsync)
 {
     int result;
     result = SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS | SDL_INIT_GAMECONTROLLER);
@@ -300,12 +796,7 @@ void App::init()
         throw std::exception();
     }
     sdl_window_ = std::make_shared<SDLWindow>("sw-renderer");
-    sdl_renderer_ = std::make_shared<SDLRenderer>(sdl_window_);
-    sdl_texture_ = std::make_shared<SDLTexture>(
-        sdl_renderer_,
-        SDL_TEXTUREACCESS_STREAMING,
-        sdl_window_->getDefaultResolution().first,
-        sdl_window_->getDefaultResolution().second);
+    sdl_renderer_ = std::make_shared<SDLRenderer>(sdl_window_, vsync);
     camera_ = std::make_shared<Camera>(20.0, 0.1, 400.0);
+    thread_pool_ = std::make_shared<ThreadPool>();
 }
-
@@ -9,8 +9,9 @@
 class Camera;
 class SDLWindow;
 class SDLRenderer;
-class SDLTexture;
+class SDLFramebuffer;
 class GameController;
+class ThreadPool;
 
 class App
 {
@@ -21,13 +22,18 @@ public:
     void run(const std::vector<std::string> &args);
 
 private:
-    void init();
+    void init(bool vsync);
+
+    // Longest sleep while idle; the previous frame is presented again after
+    // it.
+    constexpr static int IDLE_TIMEOUT = 250;
 
 private:
     std::shared_ptr<SDLWindow> sdl_window_;
     std::shared_ptr<SDLRenderer> sdl_renderer_;
-    std::shared_ptr<SDLTexture> sdl_texture_;
+    std::shared_ptr<SDLFramebuffer> sdl_framebuffer_;
     std::shared_ptr<Camera> camera_;
+    std::shared_ptr<ThreadPool> thread_pool_;
     std::unordered_map<int, std::shared_ptr<GameController>> game_controllers_;
 };
 
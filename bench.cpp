@@ -0,0 +1,912 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "camera.hpp"
+#include "camerapath.hpp"
+#include "demoscene.hpp"
+#include "line.hpp"
+#include "memoryframebuffer.hpp"
+#include "mesh.hpp"
+#include "meshlet.hpp"
+#include "meshloader.hpp"
+#include "model.hpp"
+#include "renderer.hpp"
+#include "resolutions.hpp"
+#include "scene.hpp"
+#include "threadpool.hpp"
+#include "triangle.hpp"
+#include "vertexcache.hpp"
+
+#define LOG_MODULE_NAME ("Bench")
+#include "log.hpp"
+
+namespace
+{
+    constexpr double RAD = glm::pi<double>() / 180.0;
+    constexpr int WIDTH = 1024;
+    constexpr int HEIGHT = 768;
+
+    struct Pose
+    {
+        std::string name;
+        double distance;
+        double yaw;
+        double pitch;
+    };
+
+    const std::vector<Pose> poses =
+    {
+        { "near", 20.0, 0.0, 0.0 },
+        { "orbit", 40.0, 300.0, 200.0 },
+        { "far", 150.0, 100.0, 300.0 },
+    };
+
+    // What a result was measured on. Only runs with the same fingerprint
+    // are worth comparing; swr-compare keeps one baseline per fingerprint.
+    struct Machine
+    {
+        std::string cpu;
+        int cores;
+        std::string compiler;
+        std::string build;
+
+        // FNV-1a of the fields above, as hex.
+        std::string getFingerprint() const
+        {
+            const std::string key = cpu + "|" + std::to_string(cores) + "|" + compiler + "|" + build;
+            uint64_t hash = 14695981039346656037ull;
+            for (unsigned char c : key)
+            {
+                hash ^= c;
+                hash *= 1099511628211ull;
+            }
+            std::ostringstream out;
+            out << std::hex << std::setw(16) << std::setfill('0') << hash;
+            return out.str();
+        }
+    };
+
+    Machine getMachine()
+    {
+        Machine machine;
+        machine.cpu = "unknown";
+        std::ifstream cpuinfo("/proc/cpuinfo");
+        std::string line;
+        while (std::getline(cpuinfo, line))
+        {
+            if (line.compare(0, 10, "model name") == 0 && line.find(':') != std::string::npos)
+            {
+                machine.cpu = line.substr(line.find(':') + 2);
+                break;
+            }
+        }
+        machine.cores = std::thread::hardware_concurrency();
+#if defined(__clang__)
+        machine.compiler = "clang " __clang_version__;
+#elif defined(__GNUC__)
+        machine.compiler = "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+        machine.compiler = "msvc " + std::to_string(_MSC_FULL_VER);
+#else
+        machine.compiler = "unknown";
+#endif
+#ifdef NDEBUG
+        machine.build = "release";
+#else
+        machine.build = "debug";
+#endif
+        return machine;
+    }
+
+    std::string escapeJson(const std::string &text)
+    {
+        std::string escaped;
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+                escaped += '\\';
+            escaped += c;
+        }
+        return escaped;
+    }
+
+    // Collects every measurement for the JSON report. Each result is a named
+    // benchmark with an optional variant (pose, resolution, ...), a flat
+    // list of numbers and, for timed loops, every sample for significance
+    // tests in swr-compare.
+    class Report
+    {
+    public:
+        using Values = std::vector<std::pair<std::string, double>>;
+
+        void add(
+            const std::string &name,
+            const std::string &variant,
+            const Values &values,
+            const std::vector<double> &samples = std::vector<double>())
+        {
+            results_.push_back(Result{ name, variant, values, samples });
+        }
+
+        void write(std::ostream &out, int frames, unsigned int seed, int threads) const
+        {
+            const Machine machine = getMachine();
+            out << std::setprecision(9);
+            out << "{\n";
+            out << "  \"frames\": " << frames << ",\n";
+            out << "  \"seed\": " << seed << ",\n";
+            out << "  \"threads\": " << threads << ",\n";
+            out << "  \"machine\": {"
+                << " \"cpu\": \"" << escapeJson(machine.cpu) << "\","
+                << " \"cores\": " << machine.cores << ","
+                << " \"compiler\": \"" << escapeJson(machine.compiler) << "\","
+                << " \"build\": \"" << machine.build << "\","
+                << " \"fingerprint\": \"" << machine.getFingerprint() << "\" },\n";
+            out << "  \"results\": [";
+            for (size_t i = 0; i < results_.size(); i++)
+            {
+                const Result &result = results_[i];
+                out << (i ? ",\n" : "\n");
+                out << "    { \"name\": \"" << result.name << "\"";
+                out << ", \"variant\": \"" << result.variant << "\"";
+                for (const auto &value : result.values)
+                    out << ", \"" << value.first << "\": " << value.second;
+                if (!result.samples.empty())
+                {
+                    out << ", \"samples_ms\": [";
+                    for (size_t j = 0; j < result.samples.size(); j++)
+                        out << (j ? ", " : "") << result.samples[j];
+                    out << "]";
+                }
+                out << " }";
+            }
+            out << "\n  ]\n}\n";
+        }
+
+    private:
+        struct Result
+        {
+            std::string name;
+            std::string variant;
+            Values values;
+            std::vector<double> samples;
+        };
+
+        std::vector<Result> results_;
+    };
+
+    // Summary of per-iteration timings, in milliseconds.
+    Report::Values summarize(std::vector<double> samples)
+    {
+        std::sort(samples.begin(), samples.end());
+        double total = 0.0;
+        for (double sample : samples)
+            total += sample;
+        return Report::Values
+        {
+            { "iterations", (double)samples.size() },
+            { "mean_ms", total / samples.size() },
+            { "median_ms", samples[samples.size() / 2] },
+            { "min_ms", samples.front() },
+            { "max_ms", samples.back() }
+        };
+    }
+
+    void printSummary(const std::string &name, const std::string &variant, const Report::Values &values)
+    {
+        std::cout << std::left << std::setw(16) << name << std::setw(20) << variant;
+        for (const auto &value : values)
+            std::cout << " " << value.first << " " << std::fixed << std::setprecision(3) << value.second;
+        std::cout << std::endl;
+    }
+
+    Mesh teapotGrid(int n, double spacing)
+    {
+        Mesh teapot;
+        loadTeapot(teapot);
+
+        Mesh grid;
+        const auto &vertices = teapot.getVertices();
+        const auto &indices = teapot.getIndices();
+        const auto &colors = teapot.getColors();
+        for (int gx = 0; gx < n; gx++)
+        {
+            for (int gz = 0; gz < n; gz++)
+            {
+                const glm::dvec3 offset(
+                    (gx - (n - 1) / 2.0) * spacing,
+                    0.0,
+                    (gz - (n - 1) / 2.0) * spacing);
+                for (int i = 0; i < (int)indices.size() / 3; i++)
+                {
+                    int v[3];
+                    for (int k = 0; k < 3; k++)
+                        v[k] = grid.addVertex(glm::dvec3(vertices[indices[3 * i + k]]) + offset);
+                    grid.addTriangle(v[0], v[1], v[2], colors[i]);
+                }
+            }
+        }
+        return grid;
+    }
+
+    // Stand-in for a dense scan when no OBJ file is given: every triangle
+    // split into four, repeatedly.
+    Mesh subdivide(const Mesh &mesh)
+    {
+        Mesh out;
+        const auto &vertices = mesh.getVertices();
+        const auto &indices = mesh.getIndices();
+        const auto &colors = mesh.getColors();
+        for (int i = 0; i < (int)indices.size() / 3; i++)
+        {
+            const glm::dvec3 a(vertices[indices[3 * i + 0]]);
+            const glm::dvec3 b(vertices[indices[3 * i + 1]]);
+            const glm::dvec3 c(vertices[indices[3 * i + 2]]);
+            const int ia = out.addVertex(a);
+            const int ib = out.addVertex(b);
+            const int ic = out.addVertex(c);
+            const int iab = out.addVertex(0.5 * (a + b));
+            const int ibc = out.addVertex(0.5 * (b + c));
+            const int ica = out.addVertex(0.5 * (c + a));
+            out.addTriangle(ia, iab, ica, colors[i]);
+            out.addTriangle(iab, ib, ibc, colors[i]);
+            out.addTriangle(ica, ibc, ic, colors[i]);
+            out.addTriangle(iab, ibc, ica, colors[i]);
+        }
+        return out;
+    }
+
+    glm::dmat4 poseView(const Pose &pose)
+    {
+        Camera camera(pose.distance, 0.1, 400.0);
+        camera.rotate(pose.yaw, pose.pitch);
+        return camera.get();
+    }
+
+    void rasterize(const Mesh &mesh, std::vector<double> &depth)
+    {
+        const auto &vertices = mesh.getVertices();
+        const auto &indices = mesh.getIndices();
+        for (int i = 0; i < (int)indices.size() / 3; i++)
+        {
+            const glm::dvec4 &a = vertices[indices[3 * i + 0]];
+            const glm::dvec4 &b = vertices[indices[3 * i + 1]];
+            const glm::dvec4 &c = vertices[indices[3 * i + 2]];
+            triangle(
+                a.x, a.y, a.z,
+                b.x, b.y, b.z,
+                c.x, c.y, c.z,
+                [&depth](int x, int y, double z)
+                {
+                    double &d = depth[x + y * WIDTH];
+                    if (z <= d)
+                        d = z;
+                });
+        }
+    }
+
+    double milliseconds(
+        std::chrono::steady_clock::time_point a,
+        std::chrono::steady_clock::time_point b)
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(b - a).count() / 1000.0;
+    }
+
+    void benchVertexCache(
+        const std::string &name,
+        const Mesh &mesh,
+        int frames,
+        Report &report)
+    {
+        Mesh optimized = mesh;
+        optimizeVertexCache(optimized);
+
+        const glm::dmat4 viewport(
+            WIDTH / 2.0, 0.0, 0.0, 0.0,
+            0.0, HEIGHT / 2.0, 0.0, 0.0,
+            0.0, 0.0, 10.0, 0.0,
+            (WIDTH - 1) / 2.0, (HEIGHT - 1) / 2.0, 0.0, 1.0);
+        const glm::dmat4 projection =
+            glm::perspective(27.0 * RAD, (double)WIDTH / (double)HEIGHT, 0.1, 400.0);
+        const glm::dmat4 view = poseView(poses[1]);
+
+        const Mesh *meshes[2] = { &mesh, &optimized };
+        const char *labels[2] = { "source", "optimized" };
+        for (int i = 0; i < 2; i++)
+        {
+            double transform_ms = 0.0;
+            double clip_ms = 0.0;
+            for (int frame = 0; frame < frames; frame++)
+            {
+                auto a = std::chrono::steady_clock::now();
+                Mesh current = *meshes[i];
+                current *= view;
+                auto b = std::chrono::steady_clock::now();
+                current.clip(projection, viewport);
+                auto c = std::chrono::steady_clock::now();
+                transform_ms += milliseconds(a, b);
+                clip_ms += milliseconds(b, c);
+            }
+
+            std::cout <<
+                std::left << std::setw(16) << name <<
+                std::setw(10) << labels[i] <<
+                " ACMR " << std::fixed << std::setprecision(3) << computeAcmr(meshes[i]->getIndices()) <<
+                " transform " << std::setw(9) << transform_ms / frames << " ms" <<
+                " clip " << std::setw(9) << clip_ms / frames << " ms" <<
+                std::endl;
+
+            report.add(
+                "vertex_cache",
+                name + "/" + labels[i],
+                {
+                    { "acmr", computeAcmr(meshes[i]->getIndices()) },
+                    { "transform_ms", transform_ms / frames },
+                    { "clip_ms", clip_ms / frames }
+                });
+        }
+    }
+
+    void benchScene(
+        int object_count,
+        unsigned int seed,
+        ThreadPool &thread_pool,
+        Report &report)
+    {
+        Mesh teapot;
+        loadTeapot(teapot);
+        auto model = std::make_shared<const Model>(teapot);
+
+        // Objects scattered through a cube sized so density stays constant.
+        std::mt19937 rng(seed);
+        const double extent = 10.0 * std::cbrt((double)object_count);
+        std::uniform_real_distribution<double> position(-extent, extent);
+        std::vector<glm::dmat4> transforms;
+        for (int i = 0; i < object_count; i++)
+            transforms.push_back(glm::translate(
+                glm::identity<glm::dmat4>(),
+                glm::dvec3(position(rng), position(rng), position(rng))));
+
+        Scene serial;
+        Scene parallel;
+        for (const auto &transform : transforms)
+        {
+            serial.addObject(model, transform);
+            parallel.addObject(model, transform);
+        }
+
+        auto a = std::chrono::steady_clock::now();
+        serial.update();
+        auto b = std::chrono::steady_clock::now();
+        parallel.update(&thread_pool);
+        auto c = std::chrono::steady_clock::now();
+
+        // Move 1% of the objects a short distance and refit.
+        std::uniform_int_distribution<int> pick(0, object_count - 1);
+        std::uniform_real_distribution<double> step(-2.0, 2.0);
+        const int moved = glm::max(1, object_count / 100);
+        for (int i = 0; i < moved; i++)
+        {
+            const int id = pick(rng);
+            parallel.setTransform(
+                id,
+                glm::translate(
+                    parallel.getObject(id).transform,
+                    glm::dvec3(step(rng), step(rng), step(rng))));
+        }
+        auto d = std::chrono::steady_clock::now();
+        parallel.update(&thread_pool);
+        auto e = std::chrono::steady_clock::now();
+
+        const glm::dmat4 projection =
+            glm::perspective(27.0 * RAD, (double)WIDTH / (double)HEIGHT, 0.1, 400.0);
+
+        std::vector<int> visible;
+        for (const auto &pose : poses)
+        {
+            const glm::dmat4 view = poseView(pose);
+            const int repeats = 10;
+
+            auto f = std::chrono::steady_clock::now();
+            for (int i = 0; i < repeats; i++)
+            {
+                visible.clear();
+                parallel.cull(view, projection, visible);
+            }
+            auto g = std::chrono::steady_clock::now();
+
+            const Frustum frustum(projection * view);
+            int brute_force = 0;
+            for (int i = 0; i < repeats; i++)
+            {
+                brute_force = 0;
+                for (int id = 0; id < object_count; id++)
+                    if (frustum.classify(parallel.getBounds(id)) != Frustum::OUTSIDE)
+                        brute_force++;
+            }
+            auto h = std::chrono::steady_clock::now();
+
+            std::cout <<
+                std::left << std::setw(16) << "scene" <<
+                std::setw(8) << pose.name <<
+                " objects " << std::setw(8) << object_count <<
+                " visible " << std::setw(8) << visible.size() <<
+                " (" << brute_force << ")" <<
+                std::fixed << std::setprecision(3) <<
+                " bvh " << std::setw(9) << milliseconds(f, g) / repeats << " ms" <<
+                " brute force " << std::setw(9) << milliseconds(g, h) / repeats << " ms" <<
+                std::endl;
+
+            report.add(
+                "scene_cull",
+                pose.name,
+                {
+                    { "objects", (double)object_count },
+                    { "visible", (double)visible.size() },
+                    { "bvh_ms", milliseconds(f, g) / repeats },
+                    { "brute_force_ms", milliseconds(g, h) / repeats }
+                });
+        }
+
+        std::cout <<
+            std::left << std::setw(16) << "scene" <<
+            " objects " << std::setw(8) << object_count <<
+            " nodes " << parallel.getBvh().getNodeCount() <<
+            std::fixed << std::setprecision(3) <<
+            " build " << std::setw(9) << milliseconds(a, b) << " ms" <<
+            " parallel build " << std::setw(9) << milliseconds(b, c) << " ms" <<
+            " move " << moved <<
+            " refit " << std::setw(9) << milliseconds(d, e) << " ms" <<
+            std::endl;
+
+        report.add(
+            "scene_build",
+            "",
+            {
+                { "objects", (double)object_count },
+                { "nodes", (double)parallel.getBvh().getNodeCount() },
+                { "build_ms", milliseconds(a, b) },
+                { "parallel_build_ms", milliseconds(b, c) },
+                { "moved", (double)moved },
+                { "refit_ms", milliseconds(d, e) }
+            });
+    }
+
+    void benchMeshlets(
+        const std::string &name,
+        const Mesh &mesh,
+        int frames,
+        ThreadPool &thread_pool,
+        Report &report)
+    {
+        const std::vector<Meshlet> meshlets = Meshlet::build(mesh);
+        const int triangle_count = mesh.getIndices().size() / 3;
+
+        const glm::dmat4 viewport(
+            WIDTH / 2.0, 0.0, 0.0, 0.0,
+            0.0, HEIGHT / 2.0, 0.0, 0.0,
+            0.0, 0.0, 10.0, 0.0,
+            (WIDTH - 1) / 2.0, (HEIGHT - 1) / 2.0, 0.0, 1.0);
+        const glm::dmat4 projection =
+            glm::perspective(27.0 * RAD, (double)WIDTH / (double)HEIGHT, 0.1, 400.0);
+
+        std::vector<double> depth(WIDTH * HEIGHT);
+        std::vector<int> visible;
+        std::vector<Mesh> clipped;
+
+        for (const auto &pose : poses)
+        {
+            const glm::dmat4 view = poseView(pose);
+
+            auto a = std::chrono::steady_clock::now();
+            for (int frame = 0; frame < frames; frame++)
+            {
+                for (auto &d : depth)
+                    d = std::numeric_limits<double>::max();
+                Mesh current = mesh;
+                current *= view;
+                current.clip(projection, viewport);
+                rasterize(current, depth);
+            }
+            auto b = std::chrono::steady_clock::now();
+
+            int culled_triangles = 0;
+            for (int frame = 0; frame < frames; frame++)
+            {
+                for (auto &d : depth)
+                    d = std::numeric_limits<double>::max();
+
+                visible.clear();
+                culled_triangles = 0;
+                for (int i = 0; i < (int)meshlets.size(); i++)
+                {
+                    if (meshlets[i].isVisible(view, projection))
+                        visible.push_back(i);
+                    else
+                        culled_triangles += meshlets[i].getMesh().getIndices().size() / 3;
+                }
+
+                clipped.resize(visible.size());
+                thread_pool.parallelFor(
+                    visible.size(),
+                    [&](int i)
+                    {
+                        clipped[i] = meshlets[visible[i]].getMesh();
+                        clipped[i] *= view;
+                        clipped[i].clip(projection, viewport);
+                    });
+
+                for (const auto &m : clipped)
+                    rasterize(m, depth);
+            }
+            auto c = std::chrono::steady_clock::now();
+
+            std::cout <<
+                std::left << std::setw(16) << name <<
+                std::setw(8) << pose.name <<
+                " triangles " << std::setw(8) << triangle_count <<
+                " meshlets " << std::setw(6) << meshlets.size() <<
+                " culled " << std::fixed << std::setprecision(1) << std::setw(6) <<
+                100.0 * culled_triangles / triangle_count << "%" <<
+                " per-triangle " << std::setprecision(3) << std::setw(9) << milliseconds(a, b) / frames << " ms" <<
+                " meshlet " << std::setw(9) << milliseconds(b, c) / frames << " ms" <<
+                std::endl;
+
+            report.add(
+                "meshlets",
+                name + "/" + pose.name,
+                {
+                    { "triangles", (double)triangle_count },
+                    { "meshlets", (double)meshlets.size() },
+                    { "culled_percent", 100.0 * culled_triangles / triangle_count },
+                    { "per_triangle_ms", milliseconds(a, b) / frames },
+                    { "meshlet_ms", milliseconds(b, c) / frames }
+                });
+        }
+    }
+
+    // One stage at a time on fixed inputs: the teapot grid seen from the
+    // orbit pose, and vertices and lines drawn from a seeded generator.
+    void benchStages(int frames, unsigned int seed, Report &report)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        const glm::dmat4 viewport(
+            WIDTH / 2.0, 0.0, 0.0, 0.0,
+            0.0, HEIGHT / 2.0, 0.0, 0.0,
+            0.0, 0.0, 10.0, 0.0,
+            (WIDTH - 1) / 2.0, (HEIGHT - 1) / 2.0, 0.0, 1.0);
+        const glm::dmat4 projection =
+            glm::perspective(27.0 * RAD, (double)WIDTH / (double)HEIGHT, 0.1, 400.0);
+        const glm::dmat4 view = poseView(poses[1]);
+
+        auto run = [&report](const std::string &name, const std::string &variant, const std::vector<double> &samples)
+        {
+            const Report::Values values = summarize(samples);
+            printSummary(name, variant, values);
+            report.add(name, variant, values, samples);
+        };
+
+        std::mt19937 rng(seed);
+
+        // Points on a coarse lattice, so about half of them weld onto an
+        // earlier vertex like they do when loading a mesh.
+        constexpr int VERTEX_COUNT = 65536;
+        std::uniform_int_distribution<int> lattice(0, 39);
+        std::vector<glm::dvec3> points;
+        points.reserve(VERTEX_COUNT);
+        for (int i = 0; i < VERTEX_COUNT; i++)
+            points.push_back(glm::dvec3(lattice(rng), lattice(rng), lattice(rng)));
+
+        std::vector<double> samples;
+        for (int frame = 0; frame < frames; frame++)
+        {
+            Mesh mesh;
+            const auto a = Clock::now();
+            for (const glm::dvec3 &p : points)
+                mesh.addVertex(p);
+            samples.push_back(milliseconds(a, Clock::now()));
+        }
+        run("mesh_add_vertex", std::to_string(VERTEX_COUNT), samples);
+
+        const Mesh grid = teapotGrid(4, 8.0);
+        const std::string triangles = std::to_string(grid.getIndices().size() / 3);
+
+        samples.clear();
+        for (int frame = 0; frame < frames; frame++)
+        {
+            Mesh mesh = grid;
+            const auto a = Clock::now();
+            mesh *= view;
+            samples.push_back(milliseconds(a, Clock::now()));
+        }
+        run("mesh_transform", triangles, samples);
+
+        Mesh transformed = grid;
+        transformed *= view;
+        Mesh clipped;
+        samples.clear();
+        for (int frame = 0; frame < frames; frame++)
+        {
+            clipped = transformed;
+            const auto a = Clock::now();
+            clipped.clip(projection, viewport);
+            samples.push_back(milliseconds(a, Clock::now()));
+        }
+        run("mesh_clip", triangles, samples);
+
+        std::vector<double> depth(WIDTH * HEIGHT);
+        samples.clear();
+        for (int frame = 0; frame < frames; frame++)
+        {
+            std::fill(depth.begin(), depth.end(), std::numeric_limits<double>::max());
+            const auto a = Clock::now();
+            rasterize(clipped, depth);
+            samples.push_back(milliseconds(a, Clock::now()));
+        }
+        run("triangle", std::to_string(clipped.getIndices().size() / 3), samples);
+
+        constexpr int LINE_COUNT = 10000;
+        std::uniform_int_distribution<int> x(0, WIDTH - 1);
+        std::uniform_int_distribution<int> y(0, HEIGHT - 1);
+        std::uniform_real_distribution<double> z(0.0, 1.0);
+        std::vector<glm::ivec4> ends;
+        std::vector<glm::dvec2> depths;
+        for (int i = 0; i < LINE_COUNT; i++)
+        {
+            ends.push_back(glm::ivec4(x(rng), y(rng), x(rng), y(rng)));
+            depths.push_back(glm::dvec2(z(rng), z(rng)));
+        }
+        samples.clear();
+        for (int frame = 0; frame < frames; frame++)
+        {
+            std::fill(depth.begin(), depth.end(), std::numeric_limits<double>::max());
+            const auto a = Clock::now();
+            for (int i = 0; i < LINE_COUNT; i++)
+            {
+                const Line line(ends[i].x, ends[i].y, depths[i].x, ends[i].z, ends[i].w, depths[i].y);
+                for (const auto &c : line)
+                {
+                    double &d = depth[c.x_ + c.y_ * WIDTH];
+                    if (c.z_ <= d)
+                        d = c.z_;
+                }
+            }
+            samples.push_back(milliseconds(a, Clock::now()));
+        }
+        run("line", std::to_string(LINE_COUNT), samples);
+
+        MemoryFramebuffer framebuffer(WIDTH, HEIGHT);
+        FramebufferView view_rows = framebuffer.lock();
+        const std::string size = std::to_string(WIDTH) + "x" + std::to_string(HEIGHT);
+
+        samples.clear();
+        for (int frame = 0; frame < frames; frame++)
+        {
+            const auto a = Clock::now();
+            for (int row = 0; row < HEIGHT; row++)
+                std::fill_n(view_rows.getDepthRow(row), WIDTH, std::numeric_limits<double>::max());
+            samples.push_back(milliseconds(a, Clock::now()));
+        }
+        run("depth_clear", size, samples);
+
+        // What SDLTexture::clear() does to a locked texture, on plain memory
+        // so it runs without a video driver.
+        samples.clear();
+        for (int frame = 0; frame < frames; frame++)
+        {
+            const auto a = Clock::now();
+            memset(view_rows.getColorRow(0), 0, (size_t)framebuffer.getPitch() * HEIGHT);
+            samples.push_back(milliseconds(a, Clock::now()));
+        }
+        run("texture_clear", size, samples);
+        framebuffer.unlock();
+    }
+
+    // Whole frames of the teapot through the Renderer at every default
+    // window size, from each of the fixed poses. The target's content frame
+    // is reset every time, so each frame is a full redraw rather than an
+    // empty damage pass.
+    void benchFrames(
+        int frames,
+        const std::shared_ptr<ThreadPool> &thread_pool,
+        Report &report)
+    {
+        Scene scene;
+        buildTeapotScene(scene, 1, false);
+        Renderer renderer(thread_pool);
+
+        for (const auto &resolution : getDefaultResolutionList())
+        {
+            MemoryFramebuffer framebuffer(resolution.first, resolution.second);
+            const std::string size =
+                std::to_string(resolution.first) + "x" + std::to_string(resolution.second);
+
+            for (const auto &pose : poses)
+            {
+                const glm::dmat4 view = poseView(pose);
+
+                std::vector<double> samples;
+                std::vector<double> raster;
+                for (int frame = -1; frame < frames; frame++)
+                {
+                    framebuffer.setContentFrame(-1);
+                    const auto a = std::chrono::steady_clock::now();
+                    renderer.render(scene, view, framebuffer);
+                    const auto b = std::chrono::steady_clock::now();
+
+                    // The first frame warms up caches and the thread pool.
+                    if (frame < 0)
+                        continue;
+                    samples.push_back(milliseconds(a, b));
+                    raster.push_back(renderer.getStats().raster_ms);
+                }
+
+                Report::Values values = summarize(samples);
+                std::sort(raster.begin(), raster.end());
+                values.push_back({ "raster_median_ms", raster[raster.size() / 2] });
+                values.push_back({ "triangles", (double)renderer.getStats().rendered_triangles });
+                printSummary("frame", size + "/" + pose.name, values);
+                report.add("frame", size + "/" + pose.name, values, samples);
+            }
+        }
+    }
+
+    // Every frame of a recorded camera path, in order, with partial redraws
+    // as in the app, so the result depends on how the path moves. One pass
+    // warms up, the next one is timed.
+    void benchPath(
+        const std::string &file,
+        const std::shared_ptr<ThreadPool> &thread_pool,
+        Report &report)
+    {
+        CameraPath path;
+        path.load(file);
+        if (path.getFrameCount() == 0)
+            return;
+
+        Scene scene;
+        buildTeapotScene(scene, 1, false);
+        Renderer renderer(thread_pool);
+        MemoryFramebuffer framebuffer(WIDTH, HEIGHT);
+
+        std::vector<double> samples;
+        for (int pass = 0; pass < 2; pass++)
+        {
+            samples.clear();
+            for (int frame = 0; frame < path.getFrameCount(); frame++)
+            {
+                const auto a = std::chrono::steady_clock::now();
+                renderer.render(scene, path.getView(frame), framebuffer);
+                samples.push_back(milliseconds(a, std::chrono::steady_clock::now()));
+            }
+        }
+
+        // The file name without directories or extension.
+        std::string name = file.substr(file.find_last_of("/\\") + 1);
+        name = name.substr(0, name.find('.'));
+
+        const Report::Values values = summarize(samples);
+        printSummary("path", name, values);
+        report.add("path", name, values, samples);
+    }
+}
+
+// Runs headless with fixed seeds and camera poses, so two runs on the same
+// machine measure the same work. --suite picks a comma separated subset of
+// stages, frames, vertexcache, meshlets and scene; --json writes every
+// result to a file for comparing runs. Every --path FILE adds a playback of
+// that camera path, e.g. the fixtures in paths/.
+int main(int argc, char **argv)
+{
+    std::vector<std::string> args(argv, argv + argc);
+
+    int frames = 20;
+    unsigned int seed = 1234;
+    std::string obj_path;
+    std::string json_path;
+    std::string suites = "stages,frames,vertexcache,meshlets,scene";
+    std::vector<std::string> camera_paths;
+    for (int i = 1; i < (int)args.size(); i++)
+    {
+        if (args[i] == "--frames" && i + 1 < (int)args.size())
+            frames = std::max(1, std::stoi(args[++i]));
+        else if (args[i] == "--obj" && i + 1 < (int)args.size())
+            obj_path = args[++i];
+        else if (args[i] == "--seed" && i + 1 < (int)args.size())
+            seed = std::stoul(args[++i]);
+        else if (args[i] == "--json" && i + 1 < (int)args.size())
+            json_path = args[++i];
+        else if (args[i] == "--suite" && i + 1 < (int)args.size())
+            suites = args[++i];
+        else if (args[i] == "--path" && i + 1 < (int)args.size())
+            camera_paths.push_back(args[++i]);
+    }
+
+    auto enabled = [&suites](const std::string &suite)
+    {
+        std::stringstream list(suites);
+        std::string item;
+        while (std::getline(list, item, ','))
+            if (item == suite)
+                return true;
+        return false;
+    };
+
+    try
+    {
+        auto thread_pool = std::make_shared<ThreadPool>();
+        Report report;
+
+        if (enabled("stages"))
+            benchStages(frames, seed, report);
+
+        if (enabled("frames"))
+            benchFrames(frames, thread_pool, report);
+
+        for (const std::string &camera_path : camera_paths)
+            benchPath(camera_path, thread_pool, report);
+
+        Mesh teapot;
+        loadTeapot(teapot);
+        if (enabled("vertexcache"))
+            benchVertexCache("teapot", teapot, frames, report);
+
+        if (enabled("meshlets"))
+            benchMeshlets("teapot-grid", teapotGrid(8, 8.0), frames, *thread_pool, report);
+
+        if (enabled("scene"))
+            benchScene(100000, seed, *thread_pool, report);
+
+        if (enabled("vertexcache") || enabled("meshlets"))
+        {
+            Mesh scan;
+            if (obj_path.empty())
+            {
+                scan = subdivide(subdivide(subdivide(teapot)));
+            }
+            else
+            {
+                loadObj(obj_path, scan);
+            }
+
+            if (enabled("vertexcache"))
+                benchVertexCache("scan", scan, frames, report);
+            if (enabled("meshlets"))
+                benchMeshlets("scan", scan, frames, *thread_pool, report);
+        }
+
+        if (!json_path.empty())
+        {
+            std::ofstream out(json_path);
+            if (!out)
+            {
+                LOG_ERROR << "Failure in opening JSON file. (" << json_path << ")" << std::endl;
+                throw std::exception();
+            }
+            report.write(out, frames, seed, thread_pool->getThreadCount() + 1);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        LOG_SEVERE << "Uncaught exception. (" << e.what() << ")" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
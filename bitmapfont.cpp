@@ -0,0 +1,124 @@
+#include "bitmapfont.hpp"
+
+namespace
+{
+    // 5x7 glyphs for ' ' through '_', one byte per row, bit 4 is the left
+    // column. Lower case is drawn as upper case, anything else as a space.
+    const unsigned char GLYPHS[64][BitmapFont::GLYPH_HEIGHT] =
+    {
+        { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // space
+        { 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04 }, // !
+        { 0x0a, 0x0a, 0x0a, 0x00, 0x00, 0x00, 0x00 }, // "
+        { 0x0a, 0x0a, 0x1f, 0x0a, 0x1f, 0x0a, 0x0a }, // #
+        { 0x04, 0x0f, 0x14, 0x0e, 0x05, 0x1e, 0x04 }, // $
+        { 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 }, // %
+        { 0x0c, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0d }, // &
+        { 0x04, 0x04, 0x08, 0x00, 0x00, 0x00, 0x00 }, // '
+        { 0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02 }, // (
+        { 0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08 }, // )
+        { 0x00, 0x04, 0x15, 0x0e, 0x15, 0x04, 0x00 }, // *
+        { 0x00, 0x04, 0x04, 0x1f, 0x04, 0x04, 0x00 }, // +
+        { 0x00, 0x00, 0x00, 0x00, 0x0c, 0x04, 0x08 }, // ,
+        { 0x00, 0x00, 0x00, 0x1f, 0x00, 0x00, 0x00 }, // -
+        { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0c, 0x0c }, // .
+        { 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 }, // /
+        { 0x0e, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0e }, // 0
+        { 0x04, 0x0c, 0x04, 0x04, 0x04, 0x04, 0x0e }, // 1
+        { 0x0e, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1f }, // 2
+        { 0x1f, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0e }, // 3
+        { 0x02, 0x06, 0x0a, 0x12, 0x1f, 0x02, 0x02 }, // 4
+        { 0x1f, 0x10, 0x1e, 0x01, 0x01, 0x11, 0x0e }, // 5
+        { 0x06, 0x08, 0x10, 0x1e, 0x11, 0x11, 0x0e }, // 6
+        { 0x1f, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 }, // 7
+        { 0x0e, 0x11, 0x11, 0x0e, 0x11, 0x11, 0x0e }, // 8
+        { 0x0e, 0x11, 0x11, 0x0f, 0x01, 0x02, 0x0c }, // 9
+        { 0x00, 0x0c, 0x0c, 0x00, 0x0c, 0x0c, 0x00 }, // :
+        { 0x00, 0x0c, 0x0c, 0x00, 0x0c, 0x04, 0x08 }, // ;
+        { 0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02 }, // <
+        { 0x00, 0x00, 0x1f, 0x00, 0x1f, 0x00, 0x00 }, // =
+        { 0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08 }, // >
+        { 0x0e, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04 }, // ?
+        { 0x0e, 0x11, 0x01, 0x0d, 0x15, 0x15, 0x0e }, // @
+        { 0x0e, 0x11, 0x11, 0x11, 0x1f, 0x11, 0x11 }, // A
+        { 0x1e, 0x11, 0x11, 0x1e, 0x11, 0x11, 0x1e }, // B
+        { 0x0e, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0e }, // C
+        { 0x1c, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1c }, // D
+        { 0x1f, 0x10, 0x10, 0x1e, 0x10, 0x10, 0x1f }, // E
+        { 0x1f, 0x10, 0x10, 0x1e, 0x10, 0x10, 0x10 }, // F
+        { 0x0e, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0f }, // G
+        { 0x11, 0x11, 0x11, 0x1f, 0x11, 0x11, 0x11 }, // H
+        { 0x0e, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0e }, // I
+        { 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0c }, // J
+        { 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 }, // K
+        { 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1f }, // L
+        { 0x11, 0x1b, 0x15, 0x15, 0x11, 0x11, 0x11 }, // M
+        { 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 }, // N
+        { 0x0e, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0e }, // O
+        { 0x1e, 0x11, 0x11, 0x1e, 0x10, 0x10, 0x10 }, // P
+        { 0x0e, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0d }, // Q
+        { 0x1e, 0x11, 0x11, 0x1e, 0x14, 0x12, 0x11 }, // R
+        { 0x0f, 0x10, 0x10, 0x0e, 0x01, 0x01, 0x1e }, // S
+        { 0x1f, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 }, // T
+        { 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0e }, // U
+        { 0x11, 0x11, 0x11, 0x11, 0x11, 0x0a, 0x04 }, // V
+        { 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0a }, // W
+        { 0x11, 0x11, 0x0a, 0x04, 0x0a, 0x11, 0x11 }, // X
+        { 0x11, 0x11, 0x11, 0x0a, 0x04, 0x04, 0x04 }, // Y
+        { 0x1f, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1f }, // Z
+        { 0x0e, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0e }, // [
+        { 0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00 }, // backslash
+        { 0x0e, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0e }, // ]
+        { 0x04, 0x0a, 0x11, 0x00, 0x00, 0x00, 0x00 }, // ^
+        { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1f }, // _
+    };
+
+    const unsigned char *getGlyph(char c)
+    {
+        if (c >= 'a' && c <= 'z')
+            c = c - 'a' + 'A';
+        if (c < ' ' || c > '_')
+            c = ' ';
+        return GLYPHS[c - ' '];
+    }
+}
+
+int BitmapFont::getTextWidth(const std::string &text)
+{
+    return text.empty() ? 0 : (int)text.size() * CELL_WIDTH - 1;
+}
+
+void BitmapFont::drawText(
+    FramebufferView &framebuffer,
+    int x,
+    int y,
+    const std::string &text,
+    uint32_t foreground,
+    uint32_t background)
+{
+    const int width = framebuffer.getWidth();
+    const int height = framebuffer.getHeight();
+
+    for (int row = 0; row < GLYPH_HEIGHT; row++)
+    {
+        const int py = y + row;
+        if (py < 0 || py >= height)
+            continue;
+
+        uint32_t *pixels = framebuffer.getColorRow(py);
+        int px = x;
+        for (char c : text)
+        {
+            const unsigned char bits = getGlyph(c)[row];
+            // Whole cells at a time, the spacing column included, so the
+            // background comes along for free.
+            if (px >= 0 && px + CELL_WIDTH <= width)
+            {
+                uint32_t *cell = pixels + px;
+                for (int i = 0; i < GLYPH_WIDTH; i++)
+                    cell[i] = (bits >> (GLYPH_WIDTH - 1 - i)) & 1 ? foreground : background;
+                cell[GLYPH_WIDTH] = background;
+            }
+            px += CELL_WIDTH;
+        }
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "framebuffer.hpp"
+
+// Built-in 5x7 pixel font for debug text, no files or font libraries
+// involved. Covers printable ASCII from space to '_', with lower case
+// drawn as upper case; '`', '{', '|', '}' and '~' come out blank.
+class BitmapFont
+{
+public:
+    constexpr static int GLYPH_WIDTH = 5;
+    constexpr static int GLYPH_HEIGHT = 7;
+    // Advance per character and per line.
+    constexpr static int CELL_WIDTH = GLYPH_WIDTH + 1;
+    constexpr static int LINE_HEIGHT = GLYPH_HEIGHT + 2;
+
+    static int getTextWidth(const std::string &text);
+
+    // Draws text with its top left corner at (x, y). Background fills the
+    // rest of every character cell. Characters not entirely inside the
+    // framebuffer are skipped.
+    static void drawText(
+        FramebufferView &framebuffer,
+        int x,
+        int y,
+        const std::string &text,
+        uint32_t foreground,
+        uint32_t background);
+};
@@ -0,0 +1,384 @@
+#include "bvh.hpp"
+
+#include <algorithm>
+#include <limits>
+
+#include "threadpool.hpp"
+
+#define LOG_MODULE_NAME ("Bvh")
+#include "log.hpp"
+
+Aabb::Aabb() :
+    lo(std::numeric_limits<double>::max()),
+    hi(-std::numeric_limits<double>::max())
+{
+}
+
+Aabb::Aabb(const glm::dvec3 &lo, const glm::dvec3 &hi) :
+    lo(lo),
+    hi(hi)
+{
+}
+
+void Aabb::grow(const Aabb &rhs)
+{
+    lo = glm::min(lo, rhs.lo);
+    hi = glm::max(hi, rhs.hi);
+}
+
+void Aabb::grow(const glm::dvec3 &p)
+{
+    lo = glm::min(lo, p);
+    hi = glm::max(hi, p);
+}
+
+double Aabb::area() const
+{
+    const glm::dvec3 d = hi - lo;
+    if (d.x < 0.0 || d.y < 0.0 || d.z < 0.0)
+        return 0.0;
+    return 2.0 * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+glm::dvec3 Aabb::center() const
+{
+    return 0.5 * (lo + hi);
+}
+
+bool Aabb::operator==(const Aabb &rhs) const
+{
+    return lo == rhs.lo && hi == rhs.hi;
+}
+
+Frustum::Frustum(const glm::dmat4 &m)
+{
+    // Gribb & Hartmann: combinations of the rows of the matrix.
+    for (int i = 0; i < 6; i++)
+    {
+        const double sign = i < 3 ? 1.0 : -1.0;
+        const int row = i % 3;
+        glm::dvec4 plane;
+        for (int k = 0; k < 4; k++)
+            plane[k] = m[k][3] + sign * m[k][row];
+        planes[i] = plane / glm::length(glm::dvec3(plane));
+    }
+}
+
+Frustum::Result Frustum::classify(const Aabb &box) const
+{
+    Result result = INSIDE;
+    for (const auto &plane : planes)
+    {
+        // Corners of the box furthest along and against the plane normal.
+        glm::dvec3 p;
+        glm::dvec3 n;
+        for (int k = 0; k < 3; k++)
+        {
+            p[k] = plane[k] >= 0.0 ? box.hi[k] : box.lo[k];
+            n[k] = plane[k] >= 0.0 ? box.lo[k] : box.hi[k];
+        }
+        if (glm::dot(glm::dvec3(plane), p) + plane.w < 0.0)
+            return OUTSIDE;
+        if (glm::dot(glm::dvec3(plane), n) + plane.w < 0.0)
+            result = INTERSECTING;
+    }
+    return result;
+}
+
+Bvh::Bvh()
+{
+}
+
+bool Bvh::empty() const
+{
+    return nodes_.empty();
+}
+
+int Bvh::getNodeCount() const
+{
+    return nodes_.size();
+}
+
+int Bvh::split(int first, int count, const std::vector<Aabb> &boxes)
+{
+    Aabb bounds;
+    Aabb centroids;
+    for (int i = first; i < first + count; i++)
+    {
+        bounds.grow(boxes[items_[i]]);
+        centroids.grow(boxes[items_[i]].center());
+    }
+
+    struct Bin
+    {
+        Aabb box;
+        int count = 0;
+    };
+
+    double best_cost = std::numeric_limits<double>::max();
+    int best_axis = -1;
+    int best_bin = 0;
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        const double lo = centroids.lo[axis];
+        const double extent = centroids.hi[axis] - lo;
+        if (extent <= 0.0)
+            continue;
+        const double scale = BIN_COUNT / extent;
+
+        Bin bins[BIN_COUNT];
+        for (int i = first; i < first + count; i++)
+        {
+            const Aabb &box = boxes[items_[i]];
+            const int b = std::min(BIN_COUNT - 1, (int)((box.center()[axis] - lo) * scale));
+            bins[b].box.grow(box);
+            bins[b].count++;
+        }
+
+        // Sweep from the right to get the cost of every right-hand side,
+        // then from the left to evaluate each split plane.
+        double right_area[BIN_COUNT];
+        int right_count[BIN_COUNT];
+        Aabb right;
+        int n = 0;
+        for (int b = BIN_COUNT - 1; b > 0; b--)
+        {
+            right.grow(bins[b].box);
+            n += bins[b].count;
+            right_area[b] = right.area();
+            right_count[b] = n;
+        }
+
+        Aabb left;
+        n = 0;
+        for (int b = 0; b < BIN_COUNT - 1; b++)
+        {
+            left.grow(bins[b].box);
+            n += bins[b].count;
+            const double cost = left.area() * n + right_area[b + 1] * right_count[b + 1];
+            if (n > 0 && right_count[b + 1] > 0 && cost < best_cost)
+            {
+                best_cost = cost;
+                best_axis = axis;
+                best_bin = b;
+            }
+        }
+    }
+
+    // Leaf if the split does not pay for the extra traversal step.
+    const double leaf_cost = bounds.area() * count;
+    if (count <= MAX_LEAF_SIZE)
+        return 0;
+
+    if (best_axis < 0)
+    {
+        // Every centroid in the same place; split by index.
+        return count / 2;
+    }
+
+    if (best_cost + bounds.area() >= leaf_cost && count <= 4 * MAX_LEAF_SIZE)
+        return 0;
+
+    const double lo = centroids.lo[best_axis];
+    const double scale = BIN_COUNT / (centroids.hi[best_axis] - lo);
+    auto middle = std::partition(
+        items_.begin() + first,
+        items_.begin() + first + count,
+        [&](int item)
+        {
+            const int b = std::min(
+                BIN_COUNT - 1,
+                (int)((boxes[item].center()[best_axis] - lo) * scale));
+            return b <= best_bin;
+        });
+    return middle - (items_.begin() + first);
+}
+
+void Bvh::buildRange(
+    std::vector<Node> &nodes,
+    int node,
+    int first,
+    int count,
+    const std::vector<Aabb> &boxes,
+    std::vector<Task> *deferred,
+    int deferred_size)
+{
+    Aabb box;
+    for (int i = first; i < first + count; i++)
+        box.grow(boxes[items_[i]]);
+    nodes[node].box = box;
+    nodes[node].first = first;
+    nodes[node].count = count;
+    nodes[node].left = -1;
+    nodes[node].right = -1;
+
+    if (deferred && count <= deferred_size)
+    {
+        deferred->push_back(Task{ node, first, count });
+        return;
+    }
+
+    const int left_count = split(first, count, boxes);
+    if (left_count == 0)
+        return;
+
+    const int left = nodes.size();
+    nodes.push_back(Node());
+    nodes.push_back(Node());
+    nodes[node].left = left;
+    nodes[node].right = left + 1;
+    nodes[left].parent = node;
+    nodes[left + 1].parent = node;
+
+    buildRange(nodes, left, first, left_count, boxes, deferred, deferred_size);
+    buildRange(nodes, left + 1, first + left_count, count - left_count, boxes, deferred, deferred_size);
+}
+
+void Bvh::build(const std::vector<Aabb> &boxes, ThreadPool *thread_pool)
+{
+    nodes_.clear();
+    boxes_ = boxes;
+    items_.resize(boxes.size());
+    for (int i = 0; i < (int)items_.size(); i++)
+        items_[i] = i;
+    item_leaf_.assign(boxes.size(), -1);
+
+    if (boxes.empty())
+        return;
+
+    nodes_.push_back(Node());
+    nodes_[0].parent = -1;
+
+    const int count = boxes.size();
+    if (!thread_pool || thread_pool->getThreadCount() == 0 || count < PARALLEL_MIN_ITEMS)
+    {
+        buildRange(nodes_, 0, 0, count, boxes, nullptr, 0);
+    }
+    else
+    {
+        // Split the top of the tree serially until there are a few subtrees
+        // per thread, then finish those independently. Subtrees own disjoint
+        // ranges of items_, so they can partition it concurrently.
+        const int task_size = std::max(
+            PARALLEL_MIN_ITEMS / 4,
+            count / (4 * (thread_pool->getThreadCount() + 1)));
+        std::vector<Task> tasks;
+        buildRange(nodes_, 0, 0, count, boxes, &tasks, task_size);
+
+        std::vector<std::vector<Node>> subtrees(tasks.size());
+        thread_pool->parallelFor(
+            tasks.size(),
+            [this, &tasks, &subtrees, &boxes](int i)
+            {
+                auto &nodes = subtrees[i];
+                nodes.push_back(Node());
+                nodes[0].parent = -1;
+                buildRange(nodes, 0, tasks[i].first, tasks[i].count, boxes, nullptr, 0);
+            });
+
+        // Graft the subtrees: local node 0 is the placeholder left by the
+        // serial pass, the rest are appended.
+        for (int i = 0; i < (int)tasks.size(); i++)
+        {
+            const auto &nodes = subtrees[i];
+            const int root = tasks[i].node;
+            const int offset = nodes_.size() - 1;
+            auto remap = [root, offset](int n) { return n == 0 ? root : n + offset; };
+
+            Node &placeholder = nodes_[root];
+            placeholder.left = nodes[0].left < 0 ? -1 : remap(nodes[0].left);
+            placeholder.right = nodes[0].right < 0 ? -1 : remap(nodes[0].right);
+
+            for (int n = 1; n < (int)nodes.size(); n++)
+            {
+                Node node = nodes[n];
+                node.parent = remap(node.parent);
+                if (node.left >= 0)
+                {
+                    node.left = remap(node.left);
+                    node.right = remap(node.right);
+                }
+                nodes_.push_back(node);
+            }
+        }
+    }
+
+    for (int n = 0; n < (int)nodes_.size(); n++)
+        if (nodes_[n].left < 0)
+            for (int i = nodes_[n].first; i < nodes_[n].first + nodes_[n].count; i++)
+                item_leaf_[items_[i]] = n;
+}
+
+void Bvh::refit(const std::vector<int> &items, const std::vector<Aabb> &boxes)
+{
+    for (int item : items)
+        boxes_[item] = boxes[item];
+
+    for (int item : items)
+    {
+        int n = item_leaf_[item];
+        while (n >= 0)
+        {
+            Node &node = nodes_[n];
+            Aabb box;
+            if (node.left < 0)
+            {
+                for (int i = node.first; i < node.first + node.count; i++)
+                    box.grow(boxes_[items_[i]]);
+            }
+            else
+            {
+                box = nodes_[node.left].box;
+                box.grow(nodes_[node.right].box);
+            }
+
+            // Ancestors only change if this node did.
+            if (box == node.box)
+                break;
+            node.box = box;
+            n = node.parent;
+        }
+    }
+}
+
+void Bvh::cull(const Frustum &frustum, std::vector<int> &visible) const
+{
+    if (nodes_.empty())
+        return;
+
+    // Per thread scratch, so culling every frame does not allocate.
+    thread_local std::vector<int> stack;
+    stack.clear();
+    stack.reserve(64);
+    stack.push_back(0);
+    while (!stack.empty())
+    {
+        const Node &node = nodes_[stack.back()];
+        stack.pop_back();
+        switch (frustum.classify(node.box))
+        {
+        case Frustum::OUTSIDE:
+            break;
+        case Frustum::INSIDE:
+            visible.insert(
+                visible.end(),
+                items_.begin() + node.first,
+                items_.begin() + node.first + node.count);
+            break;
+        case Frustum::INTERSECTING:
+            if (node.left < 0)
+            {
+                for (int i = node.first; i < node.first + node.count; i++)
+                    if (frustum.classify(boxes_[items_[i]]) != Frustum::OUTSIDE)
+                        visible.push_back(items_[i]);
+            }
+            else
+            {
+                stack.push_back(node.left);
+                stack.push_back(node.right);
+            }
+            break;
+        }
+    }
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+class ThreadPool;
+
+struct Aabb
+{
+    Aabb();
+    Aabb(const glm::dvec3 &lo, const glm::dvec3 &hi);
+
+    void grow(const Aabb &rhs);
+    void grow(const glm::dvec3 &p);
+
+    double area() const;
+
+    glm::dvec3 center() const;
+
+    bool operator==(const Aabb &rhs) const;
+
+    glm::dvec3 lo;
+    glm::dvec3 hi;
+};
+
+// Six planes of a view frustum in the space of the matrix it was built from,
+// normals pointing inwards.
+struct Frustum
+{
+    enum Result
+    {
+        OUTSIDE,
+        INTERSECTING,
+        INSIDE
+    };
+
+    Frustum(const glm::dmat4 &view_projection);
+
+    Result classify(const Aabb &box) const;
+
+    glm::dvec4 planes[6];
+};
+
+// Bounding volume hierarchy over a set of boxes, built with binned SAH.
+// Every node covers a contiguous range of the item list, so a node that is
+// entirely inside the frustum is emitted without visiting its children.
+class Bvh
+{
+public:
+    Bvh();
+
+    // Builds from scratch. With a thread pool, subtrees below the first few
+    // levels are built in parallel.
+    void build(const std::vector<Aabb> &boxes, ThreadPool *thread_pool = nullptr);
+
+    // Updates the boxes of the given items and walks up towards the root,
+    // leaving the topology alone.
+    void refit(const std::vector<int> &items, const std::vector<Aabb> &boxes);
+
+    void cull(const Frustum &frustum, std::vector<int> &visible) const;
+
+    bool empty() const;
+
+    int getNodeCount() const;
+
+private:
+    struct Node
+    {
+        Aabb box;
+        int left;
+        int right;
+        int parent;
+        int first;
+        int count;
+    };
+
+    struct Task
+    {
+        int node;
+        int first;
+        int count;
+    };
+
+    void buildRange(
+        std::vector<Node> &nodes,
+        int node,
+        int first,
+        int count,
+        const std::vector<Aabb> &boxes,
+        std::vector<Task> *deferred,
+        int deferred_size);
+
+    int split(int first, int count, const std::vector<Aabb> &boxes);
+
+private:
+    std::vector<Node> nodes_;
+    std::vector<Aabb> boxes_;
+    std::vector<int> items_;
+    std::vector<int> item_leaf_;
+
+    constexpr static int MAX_LEAF_SIZE = 4;
+    constexpr static int BIN_COUNT = 16;
+    constexpr static int PARALLEL_MIN_ITEMS = 4096;
+};
@@ -9,7 +9,8 @@ Camera::Camera(double distance, double min_distance, double max_distance) :
 	view_matrix_(IDENTITY),
 	distance_(std::max(min_distance, std::min(distance, max_distance))),
 	min_distance_(min_distance),
-	max_distance_(max_distance)
+	max_distance_(max_distance),
+	version_(0)
 {
 	view_matrix_[3].z = -distance;
 }
@@ -20,6 +21,8 @@ constexpr glm::dvec3 forward(0.0, 0.0, 1.0);
 
 void Camera::rotate(double x, double y)
 {
+	if (x == 0.0 && y == 0.0)
+		return;
 	glm::dmat4 r =
 		glm::rotate(IDENTITY, ROTATE_SPEED * RAD * x, up) *
 		glm::rotate(IDENTITY, ROTATE_SPEED * RAD * y, right);
@@ -28,15 +31,19 @@ void Camera::rotate(double x, double y)
 		IDENTITY,
 		glm::dvec3(r * glm::dvec4(a, 0.0)) - a);
 	view_matrix_ = b * r * view_matrix_;
+	version_++;
 }
 
 void Camera::pan(double x, double y)
 {
+	if (x == 0.0 && y == 0.0)
+		return;
 	view_matrix_ =
 		glm::translate(
 			IDENTITY,
 			PAN_SPEED * distance_ * glm::dvec3(x, -y, 0.0)) *
 		view_matrix_;
+	version_++;
 }
 
 void Camera::zoom(double z)
@@ -46,7 +53,10 @@ void Camera::zoom(double z)
 		d = distance_ - max_distance_;
 	if (distance_ - d <= min_distance_)
 		d = distance_ - min_distance_;
+	if (d == 0.0)
+		return;
 	view_matrix_ = glm::translate(IDENTITY, forward * d) * view_matrix_;
 	distance_ = glm::max(min_distance_, glm::min(distance_ - d, max_distance_));
+	version_++;
 }
 
@@ -16,11 +16,15 @@ public:
 
 	glm::dmat4& get() { return view_matrix_; }
 
+	// Bumped whenever rotate, pan or zoom actually moved the camera.
+	unsigned int getVersion() const { return version_; }
+
 private:
 	glm::dmat4 view_matrix_;
 	double distance_;
 	double min_distance_;
 	double max_distance_;
+	unsigned int version_;
 
     constexpr static double ROTATE_SPEED = 1.0 / 8.0;
     constexpr static double PAN_SPEED = 1.0 / 2048.0;
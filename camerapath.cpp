@@ -0,0 +1,99 @@
+#include "camerapath.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+#define LOG_MODULE_NAME ("CameraPath")
+#include "log.hpp"
+
+namespace
+{
+    const char *const HEADER = "swr-camera-path 1";
+}
+
+CameraPath::CameraPath()
+{
+}
+
+void CameraPath::clear()
+{
+    views_.clear();
+}
+
+void CameraPath::add(const glm::dmat4 &view)
+{
+    views_.push_back(view);
+}
+
+int CameraPath::getFrameCount() const
+{
+    return views_.size();
+}
+
+const glm::dmat4 &CameraPath::getView(int frame) const
+{
+    return views_[frame];
+}
+
+void CameraPath::load(const std::string &path)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        LOG_ERROR << "Failure opening camera path file. (" << path << ")" << std::endl;
+        throw std::exception();
+    }
+
+    std::string line;
+    if (!std::getline(file, line) || line.compare(0, std::strlen(HEADER), HEADER) != 0)
+    {
+        LOG_ERROR << "Failure in camera path header. (" << path << ")" << std::endl;
+        throw std::exception();
+    }
+
+    views_.clear();
+    int line_number = 1;
+    while (std::getline(file, line))
+    {
+        line_number++;
+        if (line.empty() || line[0] == '#' || line[0] == '\r')
+            continue;
+
+        std::istringstream stream(line);
+        glm::dmat4 view;
+        for (int i = 0; i < 16; i++)
+            stream >> view[i / 4][i % 4];
+        if (!stream)
+        {
+            LOG_ERROR << "Failure in camera path, expected 16 numbers. (" << path << ":" << line_number << ")" << std::endl;
+            throw std::exception();
+        }
+        views_.push_back(view);
+    }
+
+    LOG_INFO << "Camera path loaded. (" << path << ", " << views_.size() << " frames)" << std::endl;
+}
+
+void CameraPath::save(const std::string &path) const
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        LOG_ERROR << "Failure opening camera path file. (" << path << ")" << std::endl;
+        throw std::exception();
+    }
+
+    file << HEADER << "\n";
+    file << std::setprecision(std::numeric_limits<double>::max_digits10);
+    for (const glm::dmat4 &view : views_)
+    {
+        for (int i = 0; i < 16; i++)
+            file << (i ? " " : "") << view[i / 4][i % 4];
+        file << "\n";
+    }
+
+    LOG_INFO << "Camera path saved. (" << path << ", " << views_.size() << " frames)" << std::endl;
+}
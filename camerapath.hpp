@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// One camera view matrix per frame, recorded from a session or loaded from
+// a fixture, so benchmarks replay exactly the same frames on every run.
+//
+// Stored as text: a "swr-camera-path 1" header, then one line per frame
+// with the 16 matrix elements column by column, written at full precision
+// so a path round trips bit for bit. Lines starting with '#' are comments.
+class CameraPath
+{
+public:
+    CameraPath();
+
+    void clear();
+
+    void add(const glm::dmat4 &view);
+
+    int getFrameCount() const;
+
+    const glm::dmat4 &getView(int frame) const;
+
+    void load(const std::string &path);
+
+    void save(const std::string &path) const;
+
+private:
+    std::vector<glm::dmat4> views_;
+};
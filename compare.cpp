@@ -0,0 +1,605 @@
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#define LOG_MODULE_NAME ("Compare")
+#include "log.hpp"
+
+namespace
+{
+    // Just enough JSON for swr-bench results.
+    struct Json
+    {
+        enum Type
+        {
+            NONE,
+            BOOLEAN,
+            NUMBER,
+            STRING,
+            ARRAY,
+            OBJECT
+        };
+
+        Type type = NONE;
+        bool boolean = false;
+        double number = 0.0;
+        std::string string;
+        std::vector<Json> array;
+        std::vector<std::pair<std::string, Json>> object;
+
+        const Json *get(const std::string &key) const
+        {
+            for (const auto &member : object)
+                if (member.first == key)
+                    return &member.second;
+            return nullptr;
+        }
+
+        std::string getString(const std::string &key) const
+        {
+            const Json *value = get(key);
+            return value && value->type == STRING ? value->string : std::string();
+        }
+    };
+
+    class JsonParser
+    {
+    public:
+        JsonParser(const std::string &text, const std::string &path) :
+            text_(text),
+            path_(path),
+            position_(0)
+        {
+        }
+
+        Json parse()
+        {
+            Json value = parseValue();
+            skipSpace();
+            if (position_ != text_.size())
+                fail("trailing characters");
+            return value;
+        }
+
+    private:
+        void fail(const char *what) const
+        {
+            LOG_ERROR << "Failure in parsing JSON, " << what << ". (" << path_ << ":" << position_ << ")" << std::endl;
+            throw std::exception();
+        }
+
+        void skipSpace()
+        {
+            while (position_ < text_.size() && std::isspace((unsigned char)text_[position_]))
+                position_++;
+        }
+
+        bool consume(const char *literal)
+        {
+            const size_t length = std::char_traits<char>::length(literal);
+            if (text_.compare(position_, length, literal) != 0)
+                return false;
+            position_ += length;
+            return true;
+        }
+
+        // Skips a comma between members or elements, if there is one.
+        bool consumeSeparator()
+        {
+            skipSpace();
+            if (position_ >= text_.size() || text_[position_] != ',')
+                return false;
+            position_++;
+            return true;
+        }
+
+        void expect(char c)
+        {
+            skipSpace();
+            if (position_ >= text_.size() || text_[position_] != c)
+                fail("unexpected character");
+            position_++;
+        }
+
+        std::string parseString()
+        {
+            expect('"');
+            std::string result;
+            while (position_ < text_.size() && text_[position_] != '"')
+            {
+                char c = text_[position_++];
+                if (c == '\\' && position_ < text_.size())
+                {
+                    c = text_[position_++];
+                    if (c == 'n')
+                        c = '\n';
+                    else if (c == 't')
+                        c = '\t';
+                }
+                result += c;
+            }
+            expect('"');
+            return result;
+        }
+
+        Json parseValue()
+        {
+            skipSpace();
+            if (position_ >= text_.size())
+                fail("unexpected end");
+
+            Json value;
+            const char c = text_[position_];
+            if (c == '{')
+            {
+                value.type = Json::OBJECT;
+                position_++;
+                skipSpace();
+                if (position_ < text_.size() && text_[position_] == '}')
+                {
+                    position_++;
+                    return value;
+                }
+                while (true)
+                {
+                    std::string key = parseString();
+                    expect(':');
+                    value.object.emplace_back(std::move(key), parseValue());
+                    if (!consumeSeparator())
+                        break;
+                }
+                expect('}');
+            }
+            else if (c == '[')
+            {
+                value.type = Json::ARRAY;
+                position_++;
+                skipSpace();
+                if (position_ < text_.size() && text_[position_] == ']')
+                {
+                    position_++;
+                    return value;
+                }
+                while (true)
+                {
+                    value.array.push_back(parseValue());
+                    if (!consumeSeparator())
+                        break;
+                }
+                expect(']');
+            }
+            else if (c == '"')
+            {
+                value.type = Json::STRING;
+                value.string = parseString();
+            }
+            else if (consume("true"))
+            {
+                value.type = Json::BOOLEAN;
+                value.boolean = true;
+            }
+            else if (consume("false"))
+            {
+                value.type = Json::BOOLEAN;
+            }
+            else if (consume("null"))
+            {
+                value.type = Json::NONE;
+            }
+            else
+            {
+                const char *start = text_.c_str() + position_;
+                char *end = nullptr;
+                value.type = Json::NUMBER;
+                value.number = std::strtod(start, &end);
+                if (end == start)
+                    fail("expected a value");
+                position_ += end - start;
+            }
+            return value;
+        }
+
+        const std::string &text_;
+        std::string path_;
+        size_t position_;
+    };
+
+    Json load(const std::string &path)
+    {
+        std::ifstream file(path);
+        if (!file)
+        {
+            LOG_ERROR << "Failure opening results file. (" << path << ")" << std::endl;
+            throw std::exception();
+        }
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        const std::string text = buffer.str();
+        Json json = JsonParser(text, path).parse();
+        if (json.type != Json::OBJECT || !json.get("results"))
+        {
+            LOG_ERROR << "Failure in results file, not swr-bench output. (" << path << ")" << std::endl;
+            throw std::exception();
+        }
+        return json;
+    }
+
+    struct Result
+    {
+        // Scalar values, median_ms etc.
+        std::map<std::string, double> values;
+        std::vector<double> samples;
+    };
+
+    // Results keyed by "name variant", in file order.
+    std::vector<std::pair<std::string, Result>> getResults(const Json &json)
+    {
+        std::vector<std::pair<std::string, Result>> results;
+        for (const Json &entry : json.get("results")->array)
+        {
+            Result result;
+            for (const auto &member : entry.object)
+            {
+                if (member.second.type == Json::NUMBER)
+                    result.values[member.first] = member.second.number;
+                else if (member.first == "samples_ms")
+                    for (const Json &sample : member.second.array)
+                        result.samples.push_back(sample.number);
+            }
+            const std::string variant = entry.getString("variant");
+            results.emplace_back(entry.getString("name") + (variant.empty() ? "" : " " + variant), result);
+        }
+        return results;
+    }
+
+    double median(std::vector<double> values)
+    {
+        std::sort(values.begin(), values.end());
+        const size_t n = values.size();
+        return n % 2 ? values[n / 2] : 0.5 * (values[n / 2 - 1] + values[n / 2]);
+    }
+
+    // Two sided p-value of the Mann-Whitney U test, by the normal
+    // approximation with tie and continuity corrections. Makes no
+    // assumption about the shape of the distributions, which frame times,
+    // with their long right tail, need.
+    double mannWhitney(const std::vector<double> &a, const std::vector<double> &b)
+    {
+        std::vector<std::pair<double, int>> all;
+        for (double v : a)
+            all.emplace_back(v, 0);
+        for (double v : b)
+            all.emplace_back(v, 1);
+        std::sort(all.begin(), all.end());
+
+        const double n1 = a.size();
+        const double n2 = b.size();
+        const double n = n1 + n2;
+        double rank_sum = 0.0;
+        double ties = 0.0;
+        for (size_t i = 0; i < all.size();)
+        {
+            size_t j = i;
+            while (j < all.size() && all[j].first == all[i].first)
+                j++;
+            // Tied values share the mean of their ranks.
+            const double rank = 0.5 * (i + 1 + j);
+            for (size_t k = i; k < j; k++)
+                if (all[k].second == 0)
+                    rank_sum += rank;
+            const double t = j - i;
+            ties += t * t * t - t;
+            i = j;
+        }
+
+        const double u = rank_sum - n1 * (n1 + 1.0) / 2.0;
+        const double mean = n1 * n2 / 2.0;
+        const double variance = n1 * n2 / 12.0 * ((n + 1.0) - ties / (n * (n - 1.0)));
+        if (variance <= 0.0)
+            return 1.0;
+        const double z = std::max(0.0, std::abs(u - mean) - 0.5) / std::sqrt(variance);
+        return std::erfc(z / std::sqrt(2.0));
+    }
+
+    // 95% bootstrap interval of the ratio of medians, new over old. Seeded,
+    // so the same files always give the same interval.
+    std::pair<double, double> bootstrapRatio(
+        const std::vector<double> &before,
+        const std::vector<double> &after)
+    {
+        constexpr int RESAMPLES = 2000;
+        std::mt19937 rng(1);
+        std::vector<double> ratios;
+        ratios.reserve(RESAMPLES);
+        std::vector<double> x(before.size());
+        std::vector<double> y(after.size());
+        std::uniform_int_distribution<size_t> pick_x(0, before.size() - 1);
+        std::uniform_int_distribution<size_t> pick_y(0, after.size() - 1);
+        for (int i = 0; i < RESAMPLES; i++)
+        {
+            for (double &v : x)
+                v = before[pick_x(rng)];
+            for (double &v : y)
+                v = after[pick_y(rng)];
+            const double m = median(x);
+            ratios.push_back(m > 0.0 ? median(y) / m : 1.0);
+        }
+        std::sort(ratios.begin(), ratios.end());
+        return { ratios[RESAMPLES * 25 / 1000], ratios[RESAMPLES * 975 / 1000] };
+    }
+
+    struct Row
+    {
+        std::string benchmark;
+        double before;
+        double after;
+        double change;
+        std::string interval;
+        std::string p;
+        std::string verdict;
+    };
+
+    void printTable(const std::vector<Row> &rows, bool markdown)
+    {
+        const char *headers[] = { "benchmark", "before ms", "after ms", "change", "95% ci", "p", "verdict" };
+        std::vector<std::vector<std::string>> cells;
+        for (const Row &row : rows)
+        {
+            char before[32];
+            char after[32];
+            char change[32];
+            snprintf(before, sizeof(before), "%.3f", row.before);
+            snprintf(after, sizeof(after), "%.3f", row.after);
+            snprintf(change, sizeof(change), "%+.1f%%", 100.0 * row.change);
+            cells.push_back({ row.benchmark, before, after, change, row.interval, row.p, row.verdict });
+        }
+
+        std::vector<size_t> widths;
+        for (const char *header : headers)
+            widths.push_back(std::char_traits<char>::length(header));
+        for (const auto &line : cells)
+            for (size_t i = 0; i < line.size(); i++)
+                widths[i] = std::max(widths[i], line[i].size());
+
+        auto printLine = [&](const std::vector<std::string> &line)
+        {
+            for (size_t i = 0; i < line.size(); i++)
+            {
+                // Names left aligned, numbers right aligned.
+                const std::string pad(widths[i] - line[i].size(), ' ');
+                const bool last = i == line.size() - 1;
+                std::string cell = i == 0 || last ? line[i] + pad : pad + line[i];
+                if (last && !markdown)
+                    cell = line[i];
+                std::cout << (markdown ? (i ? " | " : "| ") : (i ? "  " : "")) << cell;
+            }
+            std::cout << (markdown ? " |" : "") << "\n";
+        };
+
+        printLine(std::vector<std::string>(std::begin(headers), std::end(headers)));
+        std::vector<std::string> rule;
+        for (size_t i = 0; i < widths.size(); i++)
+        {
+            std::string dashes(widths[i], '-');
+            if (markdown && i > 0 && i < widths.size() - 1)
+                dashes.back() = ':';
+            rule.push_back(dashes);
+        }
+        printLine(rule);
+        for (const auto &line : cells)
+            printLine(line);
+        std::cout.flush();
+    }
+
+    bool copyFile(const std::string &from, const std::string &to)
+    {
+        std::ifstream in(from, std::ios::binary);
+        std::ofstream out(to, std::ios::binary);
+        if (!in || !out)
+            return false;
+        out << in.rdbuf();
+        return (bool)out;
+    }
+}
+
+// Compares two swr-bench --json results benchmark by benchmark. Results
+// with samples get a Mann-Whitney U test and a bootstrap interval of the
+// ratio of medians; a change is flagged when it is both significant (p
+// below --alpha) and larger than --threshold percent. Results without
+// samples only have their median or mean compared and are never flagged.
+// Exits with 1 when anything regressed, so CI can gate on it.
+//
+// swr-compare [options] BEFORE.json AFTER.json
+// swr-compare [options] --baselines DIR AFTER.json
+//     compares against the baseline stored for AFTER's machine
+// swr-compare --baselines DIR --save RESULTS.json
+//     stores RESULTS as the baseline of its machine
+//
+// Machines are told apart by the fingerprint swr-bench writes: CPU model,
+// core count, compiler and build type.
+int main(int argc, char **argv)
+{
+    std::vector<std::string> args(argv, argv + argc);
+
+    double threshold = 5.0;
+    double alpha = 0.01;
+    bool markdown = false;
+    std::string baselines;
+    std::string save;
+    std::vector<std::string> files;
+    for (int i = 1; i < (int)args.size(); i++)
+    {
+        if (args[i] == "--threshold" && i + 1 < (int)args.size())
+            threshold = std::stod(args[++i]);
+        else if (args[i] == "--alpha" && i + 1 < (int)args.size())
+            alpha = std::stod(args[++i]);
+        else if (args[i] == "--markdown")
+            markdown = true;
+        else if (args[i] == "--baselines" && i + 1 < (int)args.size())
+            baselines = args[++i];
+        else if (args[i] == "--save" && i + 1 < (int)args.size())
+            save = args[++i];
+        else
+            files.push_back(args[i]);
+    }
+
+    try
+    {
+        if (!save.empty())
+        {
+            const Json results = load(save);
+            const Json *machine = results.get("machine");
+            const std::string fingerprint = machine ? machine->getString("fingerprint") : std::string();
+            if (baselines.empty() || fingerprint.empty())
+            {
+                LOG_ERROR << "Failure in --save, needs --baselines and results with a machine fingerprint. (" << save << ")" << std::endl;
+                return EXIT_FAILURE;
+            }
+            const std::string path = baselines + "/" + fingerprint + ".json";
+            if (!copyFile(save, path))
+            {
+                LOG_ERROR << "Failure writing baseline. (" << path << ")" << std::endl;
+                return EXIT_FAILURE;
+            }
+            std::cout << "baseline " << path << " " << machine->getString("cpu") << std::endl;
+            return EXIT_SUCCESS;
+        }
+
+        std::string before_path;
+        std::string after_path;
+        if (files.size() == 2)
+        {
+            before_path = files[0];
+            after_path = files[1];
+        }
+        else if (files.size() == 1 && !baselines.empty())
+        {
+            after_path = files[0];
+            const Json results = load(after_path);
+            const Json *machine = results.get("machine");
+            const std::string fingerprint = machine ? machine->getString("fingerprint") : std::string();
+            before_path = baselines + "/" + fingerprint + ".json";
+            if (fingerprint.empty() || !std::ifstream(before_path))
+            {
+                LOG_ERROR << "Failure finding a baseline for this machine, store one with --save. (" << before_path << ")" << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+        else
+        {
+            LOG_ERROR << "Failure in arguments, expected BEFORE.json AFTER.json or --baselines DIR AFTER.json." << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        const Json before = load(before_path);
+        const Json after = load(after_path);
+
+        const Json *before_machine = before.get("machine");
+        const Json *after_machine = after.get("machine");
+        const std::string before_fingerprint = before_machine ? before_machine->getString("fingerprint") : "unknown";
+        const std::string after_fingerprint = after_machine ? after_machine->getString("fingerprint") : "unknown";
+        if (before_fingerprint != after_fingerprint)
+        {
+            LOG_WARNING << "Results come from different machines or builds, differences may not be the code's. ("
+                << before_fingerprint << ", " << after_fingerprint << ")" << std::endl;
+        }
+
+        const auto before_results = getResults(before);
+        std::map<std::string, Result> before_by_key(before_results.begin(), before_results.end());
+
+        std::vector<Row> rows;
+        int regressions = 0;
+        int improvements = 0;
+        for (const auto &entry : getResults(after))
+        {
+            const auto found = before_by_key.find(entry.first);
+            if (found == before_by_key.end())
+                continue;
+            const Result &old_result = found->second;
+            const Result &new_result = entry.second;
+
+            Row row;
+            row.benchmark = entry.first;
+            row.interval = "-";
+            row.p = "-";
+
+            constexpr size_t MIN_SAMPLES = 5;
+            if (old_result.samples.size() >= MIN_SAMPLES && new_result.samples.size() >= MIN_SAMPLES)
+            {
+                row.before = median(old_result.samples);
+                row.after = median(new_result.samples);
+                row.change = row.before > 0.0 ? row.after / row.before - 1.0 : 0.0;
+
+                const double p = mannWhitney(old_result.samples, new_result.samples);
+                const std::pair<double, double> interval = bootstrapRatio(old_result.samples, new_result.samples);
+                char buffer[64];
+                snprintf(buffer, sizeof(buffer), "%+.1f..%+.1f%%", 100.0 * (interval.first - 1.0), 100.0 * (interval.second - 1.0));
+                row.interval = buffer;
+                snprintf(buffer, sizeof(buffer), "%.4f", p);
+                row.p = buffer;
+
+                const bool significant = p < alpha && std::abs(100.0 * row.change) >= threshold;
+                if (significant && row.change > 0.0)
+                {
+                    row.verdict = "REGRESSION";
+                    regressions++;
+                }
+                else if (significant)
+                {
+                    row.verdict = "improvement";
+                    improvements++;
+                }
+                else
+                {
+                    row.verdict = "same";
+                }
+            }
+            else
+            {
+                // Aggregates only; the first time the two share.
+                const char *keys[] = { "median_ms", "mean_ms", "clip_ms", "meshlet_ms", "bvh_ms", "build_ms" };
+                bool found_key = false;
+                for (const char *key : keys)
+                {
+                    const auto a = old_result.values.find(key);
+                    const auto b = new_result.values.find(key);
+                    if (a == old_result.values.end() || b == new_result.values.end())
+                        continue;
+                    row.benchmark += std::string(" (") + key + ")";
+                    row.before = a->second;
+                    row.after = b->second;
+                    found_key = true;
+                    break;
+                }
+                if (!found_key)
+                    continue;
+                row.change = row.before > 0.0 ? row.after / row.before - 1.0 : 0.0;
+                row.verdict = "no samples";
+            }
+            rows.push_back(row);
+        }
+
+        printTable(rows, markdown);
+        std::cout << (markdown ? "\n" : "")
+            << rows.size() << " compared, "
+            << regressions << " regressed, "
+            << improvements << " improved"
+            << " (threshold " << threshold << "%, alpha " << alpha << ")" << std::endl;
+        return regressions ? 1 : EXIT_SUCCESS;
+    }
+    catch (const std::exception &e)
+    {
+        LOG_SEVERE << "Uncaught exception. (" << e.what() << ")" << std::endl;
+        return EXIT_FAILURE;
+    }
+}
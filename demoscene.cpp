@@ -0,0 +1,35 @@
+#include "demoscene.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "mesh.hpp"
+#include "meshloader.hpp"
+#include "model.hpp"
+#include "scene.hpp"
+
+std::shared_ptr<const Model> buildTeapotScene(
+    Scene &scene,
+    int grid,
+    bool occluders)
+{
+    constexpr double GRID_SPACING = 8.0;
+
+    Mesh mesh;
+    loadTeapot(mesh);
+    auto model = std::make_shared<const Model>(mesh);
+
+    for (int x = 0; x < grid; x++)
+        for (int z = 0; z < grid; z++)
+            scene.addObject(
+                model,
+                glm::translate(
+                    glm::identity<glm::dmat4>(),
+                    glm::dvec3(
+                        (x - (grid - 1) / 2.0) * GRID_SPACING,
+                        0.0,
+                        (z - (grid - 1) / 2.0) * GRID_SPACING)),
+                occluders);
+
+    return model;
+}
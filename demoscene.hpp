@@ -0,0 +1,14 @@
+#pragma once
+
+#include <memory>
+
+class Model;
+class Scene;
+
+// Fills the scene with a grid x grid field of teapots spaced around the
+// origin and returns the shared model. Used by every front end so that the
+// windowed, headless and benchmark runs render the same thing.
+std::shared_ptr<const Model> buildTeapotScene(
+    Scene &scene,
+    int grid,
+    bool occluders);
@@ -1,32 +1,242 @@
 #pragma once
 
-#include <glm/detail/qualifier.hpp>
-#include <glm/fwd.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
 #include <glm/glm.hpp>
 
+// Byte orders of a packed 32 bit color, named like the SDL pixel formats:
+// the first channel sits in the most significant byte. Which one is used is
+// negotiated with the presenting backend so textures upload without a
+// conversion pass, see SDLRenderer::getPixelFormat().
+enum class PixelFormat
+{
+    RGBA8888,
+    ARGB8888,
+    ABGR8888,
+    BGRA8888
+};
+
+template <PixelFormat FORMAT>
+inline uint32_t packPixel(uint32_t r, uint32_t g, uint32_t b)
+{
+    switch (FORMAT)
+    {
+    case PixelFormat::RGBA8888:
+        return (r << 24) | (g << 16) | (b << 8) | 0xffu;
+    case PixelFormat::ARGB8888:
+        return 0xff000000u | (r << 16) | (g << 8) | b;
+    case PixelFormat::ABGR8888:
+        return 0xff000000u | (b << 16) | (g << 8) | r;
+    case PixelFormat::BGRA8888:
+        return (b << 24) | (g << 16) | (r << 8) | 0xffu;
+    }
+    return 0;
+}
+
+template <PixelFormat FORMAT>
+inline uint32_t packPixel(const glm::dvec3 &c)
+{
+    return packPixel<FORMAT>(
+        (uint32_t)(255.0 * glm::clamp(c.r, 0.0, 1.0)),
+        (uint32_t)(255.0 * glm::clamp(c.g, 0.0, 1.0)),
+        (uint32_t)(255.0 * glm::clamp(c.b, 0.0, 1.0)));
+}
+
+// Runtime dispatch, for the few colors per frame not worth a template.
+inline uint32_t packPixel(PixelFormat format, const glm::dvec3 &c)
+{
+    switch (format)
+    {
+    case PixelFormat::RGBA8888:
+        return packPixel<PixelFormat::RGBA8888>(c);
+    case PixelFormat::ARGB8888:
+        return packPixel<PixelFormat::ARGB8888>(c);
+    case PixelFormat::ABGR8888:
+        return packPixel<PixelFormat::ABGR8888>(c);
+    case PixelFormat::BGRA8888:
+        return packPixel<PixelFormat::BGRA8888>(c);
+    }
+    return 0;
+}
+
+// Red, green and blue of a packed pixel, 0 to 255.
+inline glm::ivec3 unpackPixel(PixelFormat format, uint32_t p)
+{
+    switch (format)
+    {
+    case PixelFormat::RGBA8888:
+        return glm::ivec3((p >> 24) & 0xff, (p >> 16) & 0xff, (p >> 8) & 0xff);
+    case PixelFormat::ARGB8888:
+        return glm::ivec3((p >> 16) & 0xff, (p >> 8) & 0xff, p & 0xff);
+    case PixelFormat::ABGR8888:
+        return glm::ivec3(p & 0xff, (p >> 8) & 0xff, (p >> 16) & 0xff);
+    case PixelFormat::BGRA8888:
+        return glm::ivec3((p >> 8) & 0xff, (p >> 16) & 0xff, (p >> 24) & 0xff);
+    }
+    return glm::ivec3(0);
+}
+
+inline const char *getPixelFormatName(PixelFormat format)
+{
+    switch (format)
+    {
+    case PixelFormat::RGBA8888:
+        return "RGBA8888";
+    case PixelFormat::ARGB8888:
+        return "ARGB8888";
+    case PixelFormat::ABGR8888:
+        return "ABGR8888";
+    case PixelFormat::BGRA8888:
+        return "BGRA8888";
+    }
+    return "unknown";
+}
+
+// Color and depth target of the rasterizer. Pixel coordinates start at the
+// top left corner. Color is one packed 32 bit pixel in the view's
+// PixelFormat, depth is one double per pixel.
+//
+// Everything is resolved at compile time: Derived supplies getWidth(),
+// getHeight(), getColorRow(y) and getDepthRow(y), and the span and tile
+// operations below are inlined straight into the rasterizer loops. There
+// are no per-pixel virtual calls; picking a backend happens once per frame,
+// see RenderTarget.
+template <typename Derived>
 class Framebuffer
 {
 public:
-    virtual void setPixelColor(
-        const glm::ivec2 &p,
-        const glm::dvec3 &c) = 0;
+    void writeSpan(int y, int x, int count, const uint32_t *colors)
+    {
+        std::copy(colors, colors + count, derived().getColorRow(y) + x);
+    }
 
-    virtual double getPixelDepth(
-        const glm::ivec2 &p) const = 0;
+    void fillSpan(int y, int x, int count, uint32_t color)
+    {
+        std::fill_n(derived().getColorRow(y) + x, count, color);
+    }
 
-    virtual void setPixelDepth(
-        const glm::ivec2 &p,
-        double d) = 0;
+    void fillTile(int x, int y, int width, int height, uint32_t color)
+    {
+        for (int row = y; row < y + height; row++)
+            fillSpan(row, x, width, color);
+    }
 
-    virtual void clearColorBuffer(
-        const glm::dvec3 &c) = 0;
+    void clearTile(int x, int y, int width, int height, uint32_t color, double depth)
+    {
+        for (int row = y; row < y + height; row++)
+        {
+            std::fill_n(derived().getColorRow(row) + x, width, color);
+            std::fill_n(derived().getDepthRow(row) + x, width, depth);
+        }
+    }
 
-    virtual void clearDepthBuffer(
-        double d) = 0;
+    // Depth tests count pixels starting at (x, y) against z + i * dz and
+    // writes color and depth where the test passes (less or equal). Returns
+    // the number of pixels written.
+    int depthTestSpan(int y, int x, int count, double z, double dz, uint32_t color)
+    {
+        uint32_t *c = derived().getColorRow(y) + x;
+        double *d = derived().getDepthRow(y) + x;
+        int written = 0;
+        for (int i = 0; i < count; i++)
+        {
+            if (z <= d[i])
+            {
+                d[i] = z;
+                c[i] = color;
+                written++;
+            }
+            z += dz;
+        }
+        return written;
+    }
+
+    void clear(uint32_t color, double depth)
+    {
+        const int width = derived().getWidth();
+        const int height = derived().getHeight();
+        for (int y = 0; y < height; y++)
+        {
+            std::fill_n(derived().getColorRow(y), width, color);
+            std::fill_n(derived().getDepthRow(y), width, depth);
+        }
+    }
 
-protected:
-    Framebuffer()
+private:
+    Derived &derived()
     {
+        return static_cast<Derived &>(*this);
     }
 };
 
+// Raw rows of a locked render target: base pointers and strides, nothing
+// else. Cheap to copy; only valid between RenderTarget::lock() and unlock().
+class FramebufferView : public Framebuffer<FramebufferView>
+{
+public:
+    FramebufferView() :
+        color_(nullptr),
+        color_pitch_(0),
+        depth_(nullptr),
+        depth_stride_(0),
+        width_(0),
+        height_(0),
+        format_(PixelFormat::RGBA8888)
+    {
+    }
+
+    // color_pitch is in bytes, as SDL reports it; depth_stride in elements.
+    FramebufferView(
+        unsigned char *color,
+        int color_pitch,
+        double *depth,
+        int depth_stride,
+        int width,
+        int height,
+        PixelFormat format) :
+        color_(color),
+        color_pitch_(color_pitch),
+        depth_(depth),
+        depth_stride_(depth_stride),
+        width_(width),
+        height_(height),
+        format_(format)
+    {
+    }
+
+    int getWidth() const
+    {
+        return width_;
+    }
+
+    int getHeight() const
+    {
+        return height_;
+    }
+
+    PixelFormat getFormat() const
+    {
+        return format_;
+    }
+
+    uint32_t *getColorRow(int y) const
+    {
+        return reinterpret_cast<uint32_t *>(color_ + (size_t)y * color_pitch_);
+    }
+
+    double *getDepthRow(int y) const
+    {
+        return depth_ + (size_t)y * depth_stride_;
+    }
+
+private:
+    unsigned char *color_;
+    int color_pitch_;
+    double *depth_;
+    int depth_stride_;
+    int width_;
+    int height_;
+    PixelFormat format_;
+};
@@ -0,0 +1,174 @@
+#include "framepacer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+#define LOG_MODULE_NAME ("FramePacer")
+#include "log.hpp"
+
+constexpr std::chrono::microseconds FramePacer::SPIN_MARGIN;
+
+FramePacer::FramePacer(Mode mode, double rate) :
+    mode_(mode),
+    rate_(rate),
+    divisor_(1),
+    late_run_(0),
+    early_run_(0),
+    started_(false),
+    sum_squares_(0.0)
+{
+    if (rate_ <= 0.0)
+    {
+        LOG_ERROR << "Failure in FramePacer, rate must be positive. (" << rate_ << ")" << std::endl;
+        throw std::exception();
+    }
+    resetStats();
+    LOG_INFO << "Instance created. (" << getModeName(mode_) << " " << rate_ << " Hz)" << std::endl;
+}
+
+FramePacer::Mode FramePacer::getMode() const
+{
+    return mode_;
+}
+
+double FramePacer::getRate() const
+{
+    return rate_;
+}
+
+int FramePacer::getDivisor() const
+{
+    return divisor_;
+}
+
+void FramePacer::waitUntil(Clock::time_point deadline) const
+{
+    const Clock::time_point sleep_until = deadline - SPIN_MARGIN;
+    if (Clock::now() < sleep_until)
+        std::this_thread::sleep_until(sleep_until);
+    while (Clock::now() < deadline)
+        std::this_thread::yield();
+}
+
+void FramePacer::pace()
+{
+    Clock::time_point now = Clock::now();
+
+    if (mode_ == Mode::FIXED || mode_ == Mode::ADAPTIVE)
+    {
+        if (!started_)
+            deadline_ = now;
+
+        const std::chrono::duration<double> base(1.0 / rate_);
+        const Clock::duration period =
+            std::chrono::duration_cast<Clock::duration>(base * divisor_);
+        deadline_ += period;
+
+        const bool late = now > deadline_;
+        if (late)
+        {
+            // Start over from now instead of rushing out a burst of frames
+            // to catch up.
+            deadline_ = now;
+            stats_.late_frames++;
+        }
+        else
+        {
+            waitUntil(deadline_);
+        }
+
+        if (mode_ == Mode::ADAPTIVE && started_)
+        {
+            // Time the caller spent on the frame, excluding our own wait.
+            const Clock::duration work = now - last_;
+
+            late_run_ = late ? late_run_ + 1 : 0;
+            if (late_run_ >= LATE_FRAMES_TO_DROP && divisor_ < MAX_DIVISOR)
+            {
+                divisor_++;
+                late_run_ = 0;
+                early_run_ = 0;
+            }
+
+            const Clock::duration faster =
+                std::chrono::duration_cast<Clock::duration>(base * ((divisor_ - 1) * RAISE_HEADROOM));
+            early_run_ = !late && divisor_ > 1 && work < faster ? early_run_ + 1 : 0;
+            if (early_run_ >= EARLY_FRAMES_TO_RAISE)
+            {
+                divisor_--;
+                early_run_ = 0;
+            }
+        }
+
+        now = Clock::now();
+    }
+
+    if (started_)
+    {
+        const double ms = std::chrono::duration<double, std::milli>(now - last_).count();
+        stats_.frames++;
+        stats_.mean_ms += (ms - stats_.mean_ms) / stats_.frames;
+        sum_squares_ += ms * ms;
+        stats_.jitter_ms = std::sqrt(std::max(
+            0.0,
+            sum_squares_ / stats_.frames - stats_.mean_ms * stats_.mean_ms));
+        stats_.min_ms = std::min(stats_.min_ms, ms);
+        stats_.max_ms = std::max(stats_.max_ms, ms);
+    }
+    last_ = now;
+    started_ = true;
+}
+
+void FramePacer::restart()
+{
+    started_ = false;
+    late_run_ = 0;
+    early_run_ = 0;
+}
+
+const FramePacer::Stats &FramePacer::getStats() const
+{
+    return stats_;
+}
+
+void FramePacer::resetStats()
+{
+    stats_.frames = 0;
+    stats_.late_frames = 0;
+    stats_.mean_ms = 0.0;
+    stats_.jitter_ms = 0.0;
+    stats_.min_ms = std::numeric_limits<double>::max();
+    stats_.max_ms = 0.0;
+    sum_squares_ = 0.0;
+}
+
+bool FramePacer::parseMode(const std::string &name, Mode &mode)
+{
+    for (Mode m : { Mode::VSYNC, Mode::UNCAPPED, Mode::FIXED, Mode::ADAPTIVE })
+    {
+        if (name == getModeName(m))
+        {
+            mode = m;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *FramePacer::getModeName(Mode mode)
+{
+    switch (mode)
+    {
+    case Mode::VSYNC:
+        return "vsync";
+    case Mode::UNCAPPED:
+        return "uncapped";
+    case Mode::FIXED:
+        return "fixed";
+    case Mode::ADAPTIVE:
+        return "adaptive";
+    }
+    return "unknown";
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+
+// Decides when the next frame may be presented.
+//
+//  VSYNC     the presenter blocks on the display; pace() only measures.
+//  UNCAPPED  never waits, for benchmarking.
+//  FIXED     one frame every 1 / rate seconds.
+//  ADAPTIVE  like FIXED, but after a run of late frames the interval is
+//            stretched to the next divisor of the rate (60, 30, 20, 15 Hz)
+//            and tightened again once frames fit comfortably.
+//
+// Waiting sleeps until shortly before the deadline and spins the rest, since
+// sleeps overshoot by up to a scheduler tick.
+class FramePacer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum class Mode
+    {
+        VSYNC,
+        UNCAPPED,
+        FIXED,
+        ADAPTIVE
+    };
+
+    // Intervals between successive pace() returns since the last
+    // resetStats().
+    struct Stats
+    {
+        int frames;
+        int late_frames;
+        double mean_ms;
+        double jitter_ms;
+        double min_ms;
+        double max_ms;
+    };
+
+    FramePacer(Mode mode, double rate);
+
+    Mode getMode() const;
+
+    double getRate() const;
+
+    // Current divisor of the rate; only ever above 1 in ADAPTIVE mode.
+    int getDivisor() const;
+
+    // Call once per presented frame.
+    void pace();
+
+    // Forgets the previous frame after an idle period, so the gap neither
+    // counts as a late frame nor shows up in the stats.
+    void restart();
+
+    const Stats &getStats() const;
+
+    void resetStats();
+
+    static bool parseMode(const std::string &name, Mode &mode);
+
+    static const char *getModeName(Mode mode);
+
+private:
+    void waitUntil(Clock::time_point deadline) const;
+
+private:
+    Mode mode_;
+    double rate_;
+    int divisor_;
+    int late_run_;
+    int early_run_;
+
+    Clock::time_point deadline_;
+    Clock::time_point last_;
+    bool started_;
+
+    Stats stats_;
+    double sum_squares_;
+
+    constexpr static int MAX_DIVISOR = 4;
+    constexpr static int LATE_FRAMES_TO_DROP = 3;
+    constexpr static int EARLY_FRAMES_TO_RAISE = 120;
+    // Frames must fit into this fraction of the shorter interval before the
+    // rate is raised again.
+    constexpr static double RAISE_HEADROOM = 0.8;
+    constexpr static std::chrono::microseconds SPIN_MARGIN = std::chrono::microseconds(2000);
+};
@@ -0,0 +1,97 @@
+#include "framepipeline.hpp"
+
+#include "scene.hpp"
+#include "trace.hpp"
+
+#define LOG_MODULE_NAME ("FramePipeline")
+#include "log.hpp"
+
+FramePipeline::FramePipeline(Renderer &renderer, Scene &scene) :
+    renderer_(renderer),
+    scene_(scene),
+    running_(true)
+{
+    thread_ = std::thread(&FramePipeline::renderLoop, this);
+    LOG_INFO << "Instance created." << std::endl;
+}
+
+FramePipeline::~FramePipeline()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    wake_.notify_all();
+    thread_.join();
+}
+
+void FramePipeline::submit(const Input &input)
+{
+    inputs_.getBack() = input;
+    inputs_.publish();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+    }
+    wake_.notify_all();
+}
+
+const FramePipeline::Frame *FramePipeline::acquire()
+{
+    if (!frames_.acquire())
+        return nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+    }
+    wake_.notify_all();
+    return &frames_.getFront();
+}
+
+void FramePipeline::renderLoop()
+{
+    TRACE_THREAD_NAME("render");
+    long long number = 0;
+
+    for (;;)
+    {
+        {
+            // Wait for new input, and for the consumer to take the last
+            // frame before starting the next one. Nothing is rendered while
+            // nothing is submitted.
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(
+                lock,
+                [this]
+                {
+                    return !running_ ||
+                        (inputs_.isPending() && !frames_.isPending());
+                });
+            if (!running_)
+                break;
+        }
+
+        inputs_.acquire();
+        const Input &input = inputs_.getFront();
+
+        Frame &frame = frames_.getBack();
+        if (!frame.framebuffer)
+            frame.framebuffer = std::make_unique<MemoryFramebuffer>(input.width, input.height, input.format);
+        else if (frame.framebuffer->getWidth() != input.width ||
+            frame.framebuffer->getHeight() != input.height)
+            frame.framebuffer->resize(input.width, input.height);
+        frame.framebuffer->setFormat(input.format);
+
+        const Clock::time_point start = Clock::now();
+        renderer_.setOcclusionDebug(input.occlusion_debug);
+        renderer_.setDebugView(input.debug_view);
+        renderer_.render(scene_, input.view, *frame.framebuffer);
+        const Clock::time_point end = Clock::now();
+        TRACE_COMPLETE("render", start, end);
+
+        frame.input = input;
+        frame.stats = renderer_.getStats();
+        frame.damage = renderer_.getDamage();
+        frame.render_ms = std::chrono::duration<double, std::milli>(end - start).count();
+        frame.number = number++;
+        frames_.publish();
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <glm/glm.hpp>
+
+#include "memoryframebuffer.hpp"
+#include "renderer.hpp"
+#include "triplebuffer.hpp"
+
+class Scene;
+
+// Renders on a dedicated thread while the caller presents. The caller
+// submits input (camera, size) whenever it wants a new frame and acquires
+// the newest finished frame; both directions go through lock-free triple buffers. The render
+// thread stays at most one frame ahead of the consumer, so throughput
+// approaches max(render, present) rather than their sum at the cost of up
+// to one frame of extra latency.
+//
+// The Renderer and Scene belong to the render thread until the pipeline is
+// destroyed.
+class FramePipeline
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Input
+    {
+        glm::dmat4 view;
+        int width;
+        int height;
+        // Layout of the frame's pixels, matching the texture it ends up in.
+        PixelFormat format;
+        bool occlusion_debug;
+        Renderer::DebugView debug_view;
+        Clock::time_point sampled;
+        long long sequence;
+    };
+
+    struct Frame
+    {
+        std::unique_ptr<MemoryFramebuffer> framebuffer;
+        Input input;
+        Renderer::Stats stats;
+        // Tiles that differ from the previous frame.
+        TileMask damage;
+        double render_ms;
+        long long number;
+    };
+
+    FramePipeline(Renderer &renderer, Scene &scene);
+
+    ~FramePipeline();
+
+    void submit(const Input &input);
+
+    // The newest finished frame, or nullptr when none was finished since the
+    // previous call. Stays valid until the next call.
+    const Frame *acquire();
+
+private:
+    void renderLoop();
+
+private:
+    Renderer &renderer_;
+    Scene &scene_;
+
+    TripleBuffer<Input> inputs_;
+    TripleBuffer<Frame> frames_;
+
+    // Only for sleeping; no data passes through these.
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool running_;
+
+    std::thread thread_;
+};
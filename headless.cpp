@@ -0,0 +1,295 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "alloctracker.hpp"
+#include "camera.hpp"
+#include "camerapath.hpp"
+#include "demoscene.hpp"
+#include "memoryframebuffer.hpp"
+#include "perfcounters.hpp"
+#include "profiler.hpp"
+#include "renderer.hpp"
+#include "scene.hpp"
+#include "threadpool.hpp"
+#include "trace.hpp"
+
+#define LOG_MODULE_NAME ("Headless")
+#include "log.hpp"
+
+// Renders the demo scene into memory without opening a window, for CI and
+// profiling runs. The camera orbits by a fixed step per frame, so every run
+// with the same arguments renders exactly the same frames.
+//
+// --path FILE plays a recorded camera path instead, one frame per entry,
+// as fast as it renders; see the fixtures in paths/. --timing FILE writes
+// every frame's time.
+//
+// --heatmaps PREFIX renders the last frame once more in every debug view
+// and writes PREFIX-overdraw.ppm, PREFIX-depthfail.ppm and
+// PREFIX-tiletime.ppm.
+//
+// --perf counts hardware events per stage through perf_event_open and
+// prints IPC and misses per triangle or pixel after the timings.
+//
+// With allocation tracking compiled in (-DSWR_ALLOC_TRACKING=ON),
+// --alloc-report prints allocations per stage and frame and the call sites
+// allocating most. --alloc-check renders the frames twice and fails the
+// run, printing the sites, if any frame of the second pass allocates: by
+// then every buffer has grown to what the frames need, so a steady state
+// should not allocate at all.
+int main(int argc, char **argv)
+{
+    std::vector<std::string> args(argv, argv + argc);
+
+    int frames = 100;
+    int width = 1024;
+    int height = 768;
+    int grid = 1;
+    bool occlusion = false;
+    bool perf = false;
+    bool alloc_report = false;
+    bool alloc_check = false;
+    Renderer::DebugView debug_view = Renderer::DebugView::NONE;
+    std::string heatmap_prefix;
+    std::string camera_path_file;
+    std::string timing_path;
+    std::string output_path;
+    std::string trace_path;
+    for (int i = 1; i < (int)args.size(); i++)
+    {
+        if (args[i] == "--frames" && i + 1 < (int)args.size())
+            frames = std::max(1, std::stoi(args[++i]));
+        else if (args[i] == "--size" && i + 1 < (int)args.size())
+        {
+            const std::string size = args[++i];
+            const size_t x = size.find('x');
+            if (x == std::string::npos)
+            {
+                LOG_ERROR << "Failure in --size, expected WxH. (" << size << ")" << std::endl;
+                return EXIT_FAILURE;
+            }
+            width = std::max(1, std::stoi(size.substr(0, x)));
+            height = std::max(1, std::stoi(size.substr(x + 1)));
+        }
+        else if (args[i] == "--grid" && i + 1 < (int)args.size())
+            grid = std::max(1, std::stoi(args[++i]));
+        else if (args[i] == "--occlusion")
+            occlusion = true;
+        else if (args[i] == "--perf")
+            perf = true;
+        else if (args[i] == "--alloc-report")
+            alloc_report = true;
+        else if (args[i] == "--alloc-check")
+            alloc_check = true;
+        else if (args[i] == "--debug-view" && i + 1 < (int)args.size())
+        {
+            if (!Renderer::parseDebugView(args[++i], debug_view))
+            {
+                LOG_ERROR << "Failure in --debug-view, expected none, overdraw, depthfail or tiletime. (" << args[i] << ")" << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+        else if (args[i] == "--heatmaps" && i + 1 < (int)args.size())
+            heatmap_prefix = args[++i];
+        else if (args[i] == "--path" && i + 1 < (int)args.size())
+            camera_path_file = args[++i];
+        else if (args[i] == "--timing" && i + 1 < (int)args.size())
+            timing_path = args[++i];
+        else if (args[i] == "--output" && i + 1 < (int)args.size())
+            output_path = args[++i];
+        else if (args[i] == "--trace" && i + 1 < (int)args.size())
+            trace_path = args[++i];
+    }
+
+    if ((alloc_report || alloc_check) && !AllocTracker::isEnabled())
+    {
+        LOG_ERROR << "Failure in --alloc-report or --alloc-check, allocation tracking is not compiled in. Build with -DSWR_ALLOC_TRACKING=ON." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        TRACE_THREAD_NAME("main");
+        if (perf)
+            perf = PerfCounters::open();
+        auto thread_pool = std::make_shared<ThreadPool>();
+
+        Scene scene;
+        buildTeapotScene(scene, grid, occlusion);
+
+        Camera camera(20.0 * grid, 0.1, 400.0);
+        CameraPath camera_path;
+        if (!camera_path_file.empty())
+        {
+            camera_path.load(camera_path_file);
+            if (camera_path.getFrameCount() == 0)
+            {
+                LOG_ERROR << "Failure in camera path, no frames. (" << camera_path_file << ")" << std::endl;
+                throw std::exception();
+            }
+            frames = camera_path.getFrameCount();
+        }
+        MemoryFramebuffer framebuffer(width, height);
+        Renderer renderer(thread_pool);
+        renderer.setOcclusion(occlusion);
+        renderer.setDebugView(debug_view);
+
+        constexpr double ORBIT_STEP = 8.0;
+        constexpr int TOP_SITES = 10;
+
+        Profiler profiler;
+        std::vector<double> times;
+        std::vector<int> triangles;
+        times.reserve(frames);
+        triangles.reserve(frames);
+        auto getView = [&camera_path, ORBIT_STEP](int frame, Camera &orbit)
+        {
+            if (camera_path.getFrameCount())
+                return camera_path.getView(frame);
+            orbit.rotate(ORBIT_STEP, 0.0);
+            return orbit.get();
+        };
+
+        glm::dmat4 view;
+        if (alloc_check)
+        {
+            // The warm-up pass, on a copy of the camera so the second pass
+            // sees the same views.
+            Camera orbit = camera;
+            for (int frame = 0; frame < frames; frame++)
+                renderer.render(scene, getView(frame, orbit), framebuffer);
+        }
+        // The check only wants the steady state's sites.
+        if (alloc_report || alloc_check)
+            AllocTracker::enableSites();
+        int allocating_frames = 0;
+        for (int frame = 0; frame < frames; frame++)
+        {
+            view = getView(frame, camera);
+
+            AllocTracker::Counts allocations_start;
+            AllocTracker::Counts allocations_end;
+            AllocTracker::read(allocations_start);
+            const auto start = std::chrono::steady_clock::now();
+            renderer.render(scene, view, framebuffer);
+            const auto end = std::chrono::steady_clock::now();
+            AllocTracker::read(allocations_end);
+            if (allocations_end.allocations > allocations_start.allocations)
+                allocating_frames++;
+
+            times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+            const Renderer::Stats &stats = renderer.getStats();
+            triangles.push_back(stats.rendered_triangles);
+            if (perf)
+            {
+                const long long input_triangles = stats.pipeline.input_triangles;
+                profiler.recordCounters(Profiler::CULL, stats.cull_counters, input_triangles);
+                profiler.recordCounters(Profiler::TRANSFORM, stats.transform_counters, input_triangles);
+                profiler.recordCounters(Profiler::CLIP, stats.clip_counters, input_triangles);
+                profiler.recordCounters(Profiler::CLEAR, stats.clear_counters, stats.pipeline.cleared_pixels);
+                profiler.recordCounters(Profiler::RASTERIZE, stats.rasterize_counters, stats.pipeline.fragments);
+            }
+            if (AllocTracker::isEnabled())
+            {
+                profiler.recordAllocations(Profiler::CULL, stats.cull_allocations);
+                profiler.recordAllocations(Profiler::TRANSFORM, stats.transform_allocations);
+                profiler.recordAllocations(Profiler::CLIP, stats.clip_allocations);
+                profiler.recordAllocations(Profiler::CLEAR, stats.clear_allocations);
+                profiler.recordAllocations(Profiler::RASTERIZE, stats.rasterize_allocations);
+                profiler.recordAllocations(Profiler::FRAME, allocations_end - allocations_start);
+            }
+            TRACE_COMPLETE("render", start, end);
+            TRACE_FRAME(frame);
+        }
+        AllocTracker::disableSites();
+
+        if (!timing_path.empty())
+        {
+            std::ofstream out(timing_path);
+            if (!out)
+            {
+                LOG_ERROR << "Failure in opening timing file. (" << timing_path << ")" << std::endl;
+                throw std::exception();
+            }
+            out << "frame,ms,triangles\n";
+            for (int i = 0; i < frames; i++)
+                out << i << "," << times[i] << "," << triangles[i] << "\n";
+        }
+
+        if (!output_path.empty())
+            framebuffer.writePpm(output_path);
+
+        if (!heatmap_prefix.empty())
+        {
+            for (Renderer::DebugView heatmap : { Renderer::DebugView::OVERDRAW, Renderer::DebugView::DEPTH_FAIL, Renderer::DebugView::TILE_TIME })
+            {
+                renderer.setDebugView(heatmap);
+                renderer.render(scene, view, framebuffer);
+                framebuffer.writePpm(heatmap_prefix + "-" + Renderer::getDebugViewName(heatmap) + ".ppm");
+            }
+            renderer.setDebugView(debug_view);
+        }
+
+#ifdef SWR_TRACE
+        if (!trace_path.empty())
+            Trace::write(trace_path);
+#else
+        if (!trace_path.empty())
+            LOG_WARNING << "Tracing is not compiled in, --trace ignored. Build with -DSWR_TRACE=ON." << std::endl;
+#endif
+
+        std::vector<double> sorted = times;
+        std::sort(sorted.begin(), sorted.end());
+        double total = 0.0;
+        for (double t : times)
+            total += t;
+
+        std::cout << std::fixed << std::setprecision(3)
+            << "frames " << frames
+            << " size " << width << "x" << height
+            << " threads " << thread_pool->getThreadCount() + 1
+            << " mean " << total / frames << " ms"
+            << " median " << sorted[frames / 2] << " ms"
+            << " p95 " << sorted[std::min(frames - 1, frames * 95 / 100)] << " ms"
+            << " p99 " << sorted[std::min(frames - 1, frames * 99 / 100)] << " ms"
+            << " min " << sorted.front() << " ms"
+            << " max " << sorted.back() << " ms"
+            << std::endl;
+        if (perf)
+            profiler.writeCounters(std::cout);
+
+        if (alloc_report)
+        {
+            profiler.writeAllocations(std::cout);
+            std::cout << "Top allocating call sites:\n";
+            AllocTracker::writeSites(std::cout, TOP_SITES);
+        }
+
+        if (alloc_check)
+        {
+            if (allocating_frames > 0)
+            {
+                LOG_ERROR << "Failure in allocation check, " << allocating_frames << " of "
+                    << frames << " frames allocated after the warm-up." << std::endl;
+                if (!alloc_report)
+                    AllocTracker::writeSites(std::cout, TOP_SITES);
+                return EXIT_FAILURE;
+            }
+            std::cout << "No allocations in " << frames << " frames after the warm-up." << std::endl;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        LOG_SEVERE << "Uncaught exception. (" << e.what() << ")" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,90 @@
+#include "hud.hpp"
+
+#include <algorithm>
+
+#include "bitmapfont.hpp"
+#include "framebuffer.hpp"
+#include "sdlrenderer.hpp"
+#include "sdltexture.hpp"
+
+#define LOG_MODULE_NAME ("Hud")
+#include "log.hpp"
+
+Hud::Hud(const std::shared_ptr<SDLRenderer> &sdl_renderer) :
+    sdl_renderer_(sdl_renderer),
+    width_(0),
+    height_(0)
+{
+    LOG_INFO << "Instance created." << std::endl;
+}
+
+void Hud::setLines(const std::vector<std::string> &lines)
+{
+    if (lines == lines_ && sdl_texture_)
+        return;
+    lines_ = lines;
+
+    int text_width = 0;
+    for (const std::string &line : lines_)
+        text_width = std::max(text_width, BitmapFont::getTextWidth(line));
+    width_ = std::max(1, text_width + 2 * PADDING);
+    height_ = std::max(1, (int)lines_.size() * BitmapFont::LINE_HEIGHT + 2 * PADDING);
+
+    if (!sdl_texture_ ||
+        width_ > sdl_texture_->getWidth() ||
+        height_ > sdl_texture_->getHeight())
+    {
+        sdl_texture_.reset();
+        sdl_texture_ = std::make_shared<SDLTexture>(
+            sdl_renderer_,
+            SDL_TEXTUREACCESS_STREAMING,
+            (width_ + BUCKET - 1) / BUCKET * BUCKET,
+            (height_ + BUCKET - 1) / BUCKET * BUCKET);
+    }
+
+    const PixelFormat format = sdl_renderer_->getPixelFormat();
+    const uint32_t foreground = packPixel(format, glm::dvec3(1.0, 1.0, 0.6));
+    const uint32_t background = packPixel(format, glm::dvec3(0.0));
+
+    sdl_texture_->lock();
+    FramebufferView view(
+        sdl_texture_->getPixels(),
+        sdl_texture_->getPitch(),
+        nullptr,
+        0,
+        width_,
+        height_,
+        format);
+    view.fillTile(0, 0, width_, height_, background);
+    for (int i = 0; i < (int)lines_.size(); i++)
+    {
+        BitmapFont::drawText(
+            view,
+            PADDING,
+            PADDING + i * BitmapFont::LINE_HEIGHT,
+            lines_[i],
+            foreground,
+            background);
+    }
+    sdl_texture_->updateTexture();
+}
+
+void Hud::render()
+{
+    if (!sdl_texture_)
+        return;
+
+    SDL_Rect source;
+    source.x = 0;
+    source.y = 0;
+    source.w = width_;
+    source.h = height_;
+
+    SDL_Rect destination;
+    destination.x = MARGIN;
+    destination.y = MARGIN;
+    destination.w = SCALE * width_;
+    destination.h = SCALE * height_;
+
+    sdl_renderer_->renderCopy(sdl_texture_, &source, &destination);
+}
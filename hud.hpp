@@ -0,0 +1,36 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class SDLRenderer;
+class SDLTexture;
+
+// Text overlay drawn with BitmapFont into a small streaming texture of its
+// own and copied over the frame before presenting. The frame's pixels stay
+// untouched, which partial redraws and damage uploads rely on.
+class Hud
+{
+public:
+    Hud(const std::shared_ptr<SDLRenderer> &sdl_renderer);
+
+    // Redraws the texture, unless the lines are the ones already shown.
+    void setLines(const std::vector<std::string> &lines);
+
+    // Copies the overlay to the top left corner of the window.
+    void render();
+
+private:
+    std::shared_ptr<SDLRenderer> sdl_renderer_;
+    std::shared_ptr<SDLTexture> sdl_texture_;
+    std::vector<std::string> lines_;
+    int width_;
+    int height_;
+
+    constexpr static int PADDING = 3;
+    constexpr static int MARGIN = 8;
+    // Font pixels per screen pixel side.
+    constexpr static int SCALE = 2;
+    constexpr static int BUCKET = 64;
+};
@@ -0,0 +1,127 @@
+#include "lodchain.hpp"
+
+#include <glm/gtc/constants.hpp>
+
+#include "meshsimplifier.hpp"
+#include "vertexcache.hpp"
+
+#define LOG_MODULE_NAME ("LodChain")
+#include "log.hpp"
+
+LodChain::LodChain(const Mesh &mesh, int max_levels) :
+    center_(0.0),
+    radius_(0.0)
+{
+    levels_.push_back(mesh);
+
+    MeshSimplifier simplifier(mesh);
+    int target = mesh.getIndices().size() / 3;
+    for (int i = 1; i < max_levels; i++)
+    {
+        target = (int)(target * LEVEL_RATIO);
+        if (target < MIN_TRIANGLES)
+            break;
+
+        levels_.push_back(simplifier.simplify(target));
+
+        // Stop once the simplifier runs out of legal collapses.
+        if (simplifier.getTriangleCount() > target / LEVEL_RATIO)
+        {
+            levels_.pop_back();
+            break;
+        }
+    }
+
+    // Bounding sphere around the centroid of the bounding box. Simplified
+    // vertices can move off the original surface, so cover every level.
+    const auto &vertices = mesh.getVertices();
+    if (!vertices.empty())
+    {
+        glm::dvec3 lo(vertices[0]);
+        glm::dvec3 hi(vertices[0]);
+        for (const auto &v : vertices)
+        {
+            lo = glm::min(lo, glm::dvec3(v));
+            hi = glm::max(hi, glm::dvec3(v));
+        }
+        center_ = 0.5 * (lo + hi);
+        for (const auto &level : levels_)
+            for (const auto &v : level.getVertices())
+                radius_ = glm::max(radius_, glm::length(glm::dvec3(v) - center_));
+    }
+
+    for (int i = 0; i < (int)levels_.size(); i++)
+    {
+        const double before = computeAcmr(levels_[i].getIndices());
+        optimizeVertexCache(levels_[i]);
+        const double after = computeAcmr(levels_[i].getIndices());
+        LOG_INFO << "Level " << i <<
+            " triangles (" << levels_[i].getIndices().size() / 3 << ")" <<
+            " ACMR (" << before << " -> " << after << ")" << std::endl;
+    }
+}
+
+int LodChain::getLevelCount() const
+{
+    return levels_.size();
+}
+
+const Mesh &LodChain::getLevel(int level) const
+{
+    return levels_[level];
+}
+
+const glm::dvec3 &LodChain::getCenter() const
+{
+    return center_;
+}
+
+double LodChain::getRadius() const
+{
+    return radius_;
+}
+
+int LodChain::select(
+    const glm::dmat4 &model_view,
+    double focal_length,
+    int current) const
+{
+    const int last = levels_.size() - 1;
+    current = glm::clamp(current, 0, last);
+
+    // Camera looks down -z. Inside or behind the sphere means full detail.
+    const glm::dvec4 center = model_view * glm::dvec4(center_, 1.0);
+    const double scale = glm::length(glm::dvec3(model_view[0]));
+    const double radius = radius_ * scale;
+    const double distance = -center.z;
+    if (distance <= radius)
+        return 0;
+
+    const double projected_radius = focal_length * radius / distance;
+    const double budget =
+        TRIANGLE_DENSITY * glm::pi<double>() * projected_radius * projected_radius;
+
+    int desired = last;
+    for (int i = 0; i <= last; i++)
+    {
+        if (levels_[i].getIndices().size() / 3 <= budget)
+        {
+            desired = i;
+            break;
+        }
+    }
+
+    if (desired > current)
+    {
+        // Coarser: only once the current level is clearly over budget.
+        if (levels_[current].getIndices().size() / 3 > budget * (1.0 + HYSTERESIS))
+            return desired;
+    }
+    else if (desired < current)
+    {
+        // Finer: only once the finer level clearly fits.
+        if (levels_[desired].getIndices().size() / 3 < budget * (1.0 - HYSTERESIS))
+            return desired;
+    }
+    return current;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "mesh.hpp"
+
+// A chain of progressively simplified meshes built at load time. Level 0 is
+// the source mesh; each further level targets LEVEL_RATIO of the triangles of
+// the one before it.
+class LodChain
+{
+public:
+    LodChain(const Mesh &mesh, int max_levels = MAX_LEVELS);
+
+    int getLevelCount() const;
+
+    const Mesh &getLevel(int level) const;
+
+    const glm::dvec3 &getCenter() const;
+
+    double getRadius() const;
+
+    // Picks a level from the projected size of the bounding sphere.
+    // focal_length is the projection scale in pixels at unit view distance,
+    // current is the level the object used last frame and provides the
+    // hysteresis that keeps objects from popping back and forth.
+    int select(
+        const glm::dmat4 &model_view,
+        double focal_length,
+        int current) const;
+
+private:
+    std::vector<Mesh> levels_;
+    glm::dvec3 center_;
+    double radius_;
+
+    constexpr static int MAX_LEVELS = 6;
+    constexpr static double LEVEL_RATIO = 0.5;
+    constexpr static int MIN_TRIANGLES = 64;
+
+    // Triangles allowed per projected pixel of the bounding sphere.
+    constexpr static double TRIANGLE_DENSITY = 1.0 / 16.0;
+    // Fraction past a switching point before the level is changed.
+    constexpr static double HYSTERESIS = 0.25;
+};
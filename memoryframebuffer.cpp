@@ -0,0 +1,107 @@
+#include "memoryframebuffer.hpp"
+
+#include <fstream>
+
+#define LOG_MODULE_NAME ("MemoryFramebuffer")
+#include "log.hpp"
+
+MemoryFramebuffer::MemoryFramebuffer(
+    int width,
+    int height,
+    PixelFormat format) :
+    width_(0),
+    height_(0),
+    stride_(0),
+    format_(format)
+{
+    resize(width, height);
+    LOG_INFO << "Instance created." << std::endl;
+}
+
+void MemoryFramebuffer::resize(int width, int height)
+{
+    if (width != width_ || height != height_)
+        content_frame_ = -1;
+    width_ = width;
+    height_ = height;
+    // 16 elements keeps every row of both buffers 64 byte aligned.
+    stride_ = (width + 15) & ~15;
+
+    color_.resize((size_t)stride_ * height_);
+    depth_.resize((size_t)stride_ * height_);
+}
+
+void MemoryFramebuffer::setFormat(PixelFormat format)
+{
+    if (format != format_)
+        content_frame_ = -1;
+    format_ = format;
+}
+
+PixelFormat MemoryFramebuffer::getFormat() const
+{
+    return format_;
+}
+
+int MemoryFramebuffer::getWidth() const
+{
+    return width_;
+}
+
+int MemoryFramebuffer::getHeight() const
+{
+    return height_;
+}
+
+FramebufferView MemoryFramebuffer::lock()
+{
+    return FramebufferView(
+        reinterpret_cast<unsigned char *>(color_.data()),
+        stride_ * sizeof(uint32_t),
+        depth_.data(),
+        stride_,
+        width_,
+        height_,
+        format_);
+}
+
+void MemoryFramebuffer::unlock()
+{
+}
+
+bool MemoryFramebuffer::retainsContents() const
+{
+    return true;
+}
+
+const unsigned char *MemoryFramebuffer::getPixels() const
+{
+    return reinterpret_cast<const unsigned char *>(color_.data());
+}
+
+int MemoryFramebuffer::getPitch() const
+{
+    return stride_ * sizeof(uint32_t);
+}
+
+void MemoryFramebuffer::writePpm(const std::string &path) const
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+    {
+        LOG_ERROR << "Failure opening image file. (" << path << ")" << std::endl;
+        throw std::exception();
+    }
+
+    file << "P6\n" << width_ << " " << height_ << "\n255\n";
+    for (int y = 0; y < height_; y++)
+    {
+        const uint32_t *row = color_.data() + (size_t)y * stride_;
+        for (int x = 0; x < width_; x++)
+        {
+            const glm::ivec3 c = unpackPixel(format_, row[x]);
+            const char rgb[3] = { (char)c.r, (char)c.g, (char)c.b };
+            file.write(rgb, 3);
+        }
+    }
+}
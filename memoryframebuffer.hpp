@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+
+#include "alignedbuffer.hpp"
+#include "rendertarget.hpp"
+
+// Render target in plain memory, for rendering without any window or SDL
+// video subsystem. Rows are padded to whole cache lines. Storage comes from
+// AlignedBuffer, so resizing within the largest size seen so far reuses the
+// allocation.
+class MemoryFramebuffer : public RenderTarget
+{
+public:
+    MemoryFramebuffer(
+        int width,
+        int height,
+        PixelFormat format = PixelFormat::RGBA8888);
+
+    void resize(int width, int height);
+
+    // Changing the format discards the contents.
+    void setFormat(PixelFormat format);
+
+    PixelFormat getFormat() const;
+
+    int getWidth() const override;
+
+    int getHeight() const override;
+
+    FramebufferView lock() override;
+
+    void unlock() override;
+
+    bool retainsContents() const override;
+
+    const unsigned char *getPixels() const;
+
+    // Row pitch of getPixels() in bytes.
+    int getPitch() const;
+
+    // Binary PPM of the color buffer.
+    void writePpm(const std::string &path) const;
+
+private:
+    int width_;
+    int height_;
+    int stride_;
+    PixelFormat format_;
+    AlignedBuffer<uint32_t> color_;
+    AlignedBuffer<double> depth_;
+};
@@ -1,7 +1,12 @@
 #include "mesh.hpp"
 
+#include <cstdint>
+#include <cstring>
 #include <exception>
 
+#include "pipelinestats.hpp"
+#include "trace.hpp"
+
 #define LOG_MODULE_NAME ("Mesh")
 #include "log.hpp"
 
@@ -11,22 +16,54 @@ Mesh::Mesh()
 
 int Mesh::addVertex(const glm::dvec4 &v)
 {
-    try
+    if (2 * (vertices_.size() + 1) > vertex_lookup_.size())
+        growLookup();
+
+    const size_t mask = vertex_lookup_.size() - 1;
+    for (size_t slot = getLookupSlot(v);; slot = (slot + 1) & mask)
     {
-        return vertex_lookup_.at(v.x).at(v.y).at(v.z);
+        const int index = vertex_lookup_[slot];
+        if (index < 0)
+        {
+            vertex_lookup_[slot] = vertices_.size();
+            vertices_.push_back(v);
+            return vertices_.size() - 1;
+        }
+        const glm::dvec4 &u = vertices_[index];
+        if (u.x == v.x && u.y == v.y && u.z == v.z)
+            return index;
     }
-    catch (std::out_of_range &e)
+}
+
+size_t Mesh::getLookupSlot(const glm::dvec4 &v) const
+{
+    // Adding zero turns -0.0 into 0.0, which compare equal and so have to
+    // hash the same.
+    const double position[3] = { v.x + 0.0, v.y + 0.0, v.z + 0.0 };
+    uint64_t hash = 14695981039346656037ull;
+    for (double p : position)
     {
-        /*
-#ifndef NDEBUG
-        LOG_DEBUG << "Vertex out of range. (" << e.what() << ")" << std::endl;
-#endif
-		*/
+        uint64_t bits;
+        std::memcpy(&bits, &p, sizeof(bits));
+        hash = (hash ^ bits) * 1099511628211ull;
     }
+    return (size_t)(hash ^ (hash >> 29)) & (vertex_lookup_.size() - 1);
+}
 
-    vertices_.push_back(v);
-    vertex_lookup_[v.x][v.y][v.z] = vertices_.size() - 1;
-    return vertices_.size() - 1;
+void Mesh::growLookup()
+{
+    size_t size = std::max<size_t>(16, 2 * vertex_lookup_.size());
+    while (size < 2 * (vertices_.size() + 1))
+        size *= 2;
+    vertex_lookup_.assign(size, -1);
+    const size_t mask = vertex_lookup_.size() - 1;
+    for (int i = 0; i < (int)vertices_.size(); i++)
+    {
+        size_t slot = getLookupSlot(vertices_[i]);
+        while (vertex_lookup_[slot] >= 0)
+            slot = (slot + 1) & mask;
+        vertex_lookup_[slot] = i;
+    }
 }
 
 void Mesh::addTriangle(int a, int b, int c, const glm::dvec3& color)
@@ -50,16 +87,64 @@ void Mesh::addTriangle(
     colors_.push_back(color);
 }
 
-void Mesh::clip(const glm::dmat4& projection, const glm::dmat4& viewport)
+void Mesh::reorder(const std::vector<int>& triangle_order)
+{
+    std::vector<int> remap(vertices_.size(), -1);
+    std::vector<glm::dvec4> vertices;
+    std::vector<int> indices;
+    std::vector<glm::dvec3> normals;
+    std::vector<glm::dvec3> colors;
+    vertices.reserve(vertices_.size());
+    indices.reserve(indices_.size());
+    normals.reserve(normals_.size());
+    colors.reserve(colors_.size());
+
+    for (int t : triangle_order)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            int& index = remap[indices_[3 * t + k]];
+            if (index < 0)
+            {
+                index = vertices.size();
+                vertices.push_back(vertices_[indices_[3 * t + k]]);
+            }
+            indices.push_back(index);
+        }
+        normals.push_back(normals_[t]);
+        colors.push_back(colors_[t]);
+    }
+
+    vertices_.swap(vertices);
+    indices_.swap(indices);
+    normals_.swap(normals);
+    colors_.swap(colors);
+
+    vertex_lookup_.clear();
+    growLookup();
+}
+
+void Mesh::clip(
+    const glm::dmat4& projection,
+    const glm::dmat4& viewport,
+    PipelineStats* stats)
 {
+    const long long input_triangles = indices_.size() / 3;
+    long long backfaces = 0;
+    long long rejected_triangles = 0;
+    long long clipped_triangles = 0;
+
 	for (auto& v : this->vertices_)
     {
 		v = projection * v;
         v = v / v.w; // Perspective divide
     }
 
-	Mesh other;
-	std::vector<Mesh*> meshes
+	// The other half of the ping-pong between planes, kept per thread so
+	// its buffers are reused from one call to the next.
+	thread_local Mesh other;
+	other.clear();
+	Mesh* const meshes[2] =
 	{
 		this,
 		&other
@@ -68,6 +153,13 @@ void Mesh::clip(const glm::dmat4& projection, const glm::dmat4& viewport)
 	Mesh* next_mesh;
     for (int i = 0; i < 6; i++)
     {
+#ifdef SWR_TRACE
+        static const char* const plane_names[6] =
+        {
+            "clip -x", "clip -y", "clip -z", "clip +x", "clip +y", "clip +z"
+        };
+        TRACE_ZONE(plane_names[i]);
+#endif
         Mesh* current_mesh = meshes[i % 2];
         next_mesh = meshes[(i + 1) % 2];
         
@@ -75,8 +167,8 @@ void Mesh::clip(const glm::dmat4& projection, const glm::dmat4& viewport)
 		int component = i % 3;
         int triangle_count = current_mesh->indices_.size() / 3;;
 
-		std::vector<int> out;
-		std::vector<int> in;
+		int out[3];
+		int in[3];
 
         for (int j = 0; j < triangle_count; j++)
         {
@@ -88,20 +180,28 @@ void Mesh::clip(const glm::dmat4& projection, const glm::dmat4& viewport)
 				glm::dvec3 b(current_mesh->vertices_[current_mesh->indices_[index1 + 1]]);
 				glm::dvec3 c(current_mesh->vertices_[current_mesh->indices_[index1 + 2]]);
 				if (glm::cross(b - a, c - a).z < 0.0)
+				{
+					backfaces++;
 					continue;
+				}
 			}
 
+			int in_count = 0;
+			int out_count = 0;
 			for (int k = 0; k < 3; k++)
 			{
 				int index2 = current_mesh->indices_[index1 + k];
 				const auto& v = current_mesh->vertices_[index2];
 				if (sign * v[component] > v.w)
-					out.push_back(index2);
+					out[out_count++] = index2;
 				else
-					in.push_back(index2);
+					in[in_count++] = index2;
 			}
 
-			const int in_count = in.size();
+			if (in_count == 0)
+				rejected_triangles++;
+			else if (in_count < 3)
+				clipped_triangles++;
             if (in_count > 0)
             {
 				const auto color = current_mesh->colors_[j];
@@ -171,13 +271,20 @@ void Mesh::clip(const glm::dmat4& projection, const glm::dmat4& viewport)
 						normal);
 				}
             }
-			in.clear();
-			out.clear();
         }
 		current_mesh->clear();
     }
 
 	for (auto& v : next_mesh->vertices_)
 		v = viewport * v;
+
+    if (stats)
+    {
+        stats->input_triangles += input_triangles;
+        stats->backfaces += backfaces;
+        stats->rejected_triangles += rejected_triangles;
+        stats->clipped_triangles += clipped_triangles;
+        stats->emitted_triangles += next_mesh->indices_.size() / 3;
+    }
 }
 
@@ -1,12 +1,14 @@
 #pragma once
 
+#include <algorithm>
 #include <iostream>
 #include <vector>
-#include <map>
 
 #include <glm/fwd.hpp>
 #include <glm/glm.hpp>
 
+struct PipelineStats;
+
 class Mesh
 {
 public:
@@ -18,6 +20,11 @@ public:
         return vertices_;
     }
 
+    const std::vector<glm::dvec4> &getVertices() const
+    {
+        return vertices_;
+    }
+
     const std::vector<int> &getIndices() const
     {
         return indices_;
@@ -41,7 +48,15 @@ public:
     void addTriangle(
         int a, int b, int c, const glm::dvec3& color);
 
-    void clip(const glm::dmat4& projection, const glm::dmat4& viewport);
+    // Adds its triangle counts to stats when given.
+    void clip(
+        const glm::dmat4& projection,
+        const glm::dmat4& viewport,
+        PipelineStats* stats = nullptr);
+
+    // Puts the triangles in the given order and then renumbers the vertices
+    // in order of first use.
+    void reorder(const std::vector<int>& triangle_order);
 
     Mesh& operator*=(const glm::dmat4& rhs)
     {
@@ -59,9 +74,11 @@ public:
         return rhs;
     }
 
+    // Keeps the capacity, so a mesh that is refilled every frame stops
+    // allocating once it has seen its largest contents.
     void clear()
     {
-        vertex_lookup_.clear();
+        std::fill(vertex_lookup_.begin(), vertex_lookup_.end(), -1);
         vertices_.clear();
         indices_.clear();
         normals_.clear();
@@ -71,11 +88,19 @@ public:
 private:
     int addVertex(const glm::dvec4& v);
 
+    // Slot of the vertex lookup to start probing at for a position.
+    size_t getLookupSlot(const glm::dvec4& v) const;
+
+    // Doubles the lookup table and reinserts every vertex.
+    void growLookup();
+
     void addTriangle(
         int a, int b, int c, const glm::dvec3& color, const glm::dvec3& normal);
 
 private:
-    std::map<double, std::map<double, std::map<double, int>>> vertex_lookup_;
+    // Open addressing hash of vertex positions to vertex indices, -1 for
+    // empty slots; a power of two in size and at most half full.
+    std::vector<int> vertex_lookup_;
     std::vector<glm::dvec4> vertices_;
     std::vector<int> indices_;
     std::vector<glm::dvec3> normals_;
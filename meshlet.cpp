@@ -0,0 +1,201 @@
+#include "meshlet.hpp"
+
+#include <deque>
+
+#include "vertexcache.hpp"
+
+#define LOG_MODULE_NAME ("Meshlet")
+#include "log.hpp"
+
+Meshlet::Meshlet() :
+    center_(0.0),
+    radius_(0.0),
+    cone_axis_(0.0, 0.0, 1.0),
+    cone_cutoff_(1.0)
+{
+}
+
+const Mesh &Meshlet::getMesh() const
+{
+    return mesh_;
+}
+
+const glm::dvec3 &Meshlet::getCenter() const
+{
+    return center_;
+}
+
+double Meshlet::getRadius() const
+{
+    return radius_;
+}
+
+bool Meshlet::isVisible(
+    const glm::dmat4 &model_view,
+    const glm::dmat4 &projection) const
+{
+    return !isBackfaceCulled(model_view) && !isFrustumCulled(model_view, projection);
+}
+
+bool Meshlet::isFrustumCulled(
+    const glm::dmat4 &model_view,
+    const glm::dmat4 &projection) const
+{
+    const glm::dvec4 c = model_view * glm::dvec4(center_, 1.0);
+    const double r = radius_ * glm::length(glm::dvec3(model_view[0]));
+
+    // Planes of the view frustum from the rows of the projection matrix.
+    for (int i = 0; i < 6; i++)
+    {
+        const double sign = i < 3 ? 1.0 : -1.0;
+        const int row = i % 3;
+        glm::dvec4 plane;
+        for (int k = 0; k < 4; k++)
+            plane[k] = projection[k][3] + sign * projection[k][row];
+        const double l = glm::length(glm::dvec3(plane));
+        if (glm::dot(plane, c) < -r * l)
+            return true;
+    }
+    return false;
+}
+
+bool Meshlet::isBackfaceCulled(
+    const glm::dmat4 &model_view) const
+{
+    if (cone_cutoff_ >= 1.0)
+        return false;
+
+    const glm::dvec3 c(model_view * glm::dvec4(center_, 1.0));
+    const glm::dmat3 m(model_view);
+    const double scale = glm::length(m[0]);
+    const glm::dvec3 axis = (m * cone_axis_) / scale;
+
+    return glm::dot(c, axis) >= cone_cutoff_ * glm::length(c) + radius_ * scale;
+}
+
+void Meshlet::computeBounds()
+{
+    const auto &vertices = mesh_.getVertices();
+    const auto &normals = mesh_.getNormals();
+
+    glm::dvec3 lo(vertices[0]);
+    glm::dvec3 hi(vertices[0]);
+    for (const auto &v : vertices)
+    {
+        lo = glm::min(lo, glm::dvec3(v));
+        hi = glm::max(hi, glm::dvec3(v));
+    }
+    center_ = 0.5 * (lo + hi);
+    radius_ = 0.0;
+    for (const auto &v : vertices)
+        radius_ = glm::max(radius_, glm::length(glm::dvec3(v) - center_));
+
+    // Normal cone: average normal as the axis, widest deviation from it as
+    // the spread. The cutoff is the sine of the spread, so the whole cluster
+    // faces away once the view direction is within 90 - spread of the axis.
+    glm::dvec3 axis(0.0);
+    for (const auto &n : normals)
+        axis += n;
+    const double l = glm::length(axis);
+    if (l == 0.0)
+    {
+        cone_cutoff_ = 1.0;
+        return;
+    }
+    cone_axis_ = axis / l;
+
+    double min_dot = 1.0;
+    for (const auto &n : normals)
+        min_dot = glm::min(min_dot, glm::dot(n, cone_axis_));
+
+    // Spread of 90 degrees or more (or nearly so) never culls.
+    if (min_dot <= 0.1)
+        cone_cutoff_ = 1.0;
+    else
+        cone_cutoff_ = glm::sqrt(1.0 - min_dot * min_dot);
+}
+
+std::vector<Meshlet> Meshlet::build(
+    const Mesh &mesh,
+    int max_triangles,
+    int max_vertices)
+{
+    const auto &vertices = mesh.getVertices();
+    const auto &indices = mesh.getIndices();
+    const auto &colors = mesh.getColors();
+    const int triangle_count = indices.size() / 3;
+
+    std::vector<std::vector<int>> vertex_triangles(vertices.size());
+    for (int i = 0; i < triangle_count; i++)
+        for (int k = 0; k < 3; k++)
+            vertex_triangles[indices[3 * i + k]].push_back(i);
+
+    std::vector<bool> assigned(triangle_count, false);
+    std::vector<int> local(vertices.size(), -1);
+    std::vector<int> used;
+    std::deque<int> frontier;
+
+    std::vector<Meshlet> meshlets;
+
+    // Grow each meshlet breadth first across shared vertices from the first
+    // unassigned triangle, so clusters stay compact.
+    for (int seed = 0; seed < triangle_count; seed++)
+    {
+        if (assigned[seed])
+            continue;
+
+        Meshlet meshlet;
+        int vertex_count = 0;
+        int count = 0;
+        frontier.clear();
+        frontier.push_back(seed);
+
+        while (!frontier.empty() && count < max_triangles)
+        {
+            const int t = frontier.front();
+            frontier.pop_front();
+            if (assigned[t])
+                continue;
+
+            int added = 0;
+            for (int k = 0; k < 3; k++)
+                if (local[indices[3 * t + k]] < 0)
+                    added++;
+            if (vertex_count + added > max_vertices)
+                continue;
+
+            int v[3];
+            for (int k = 0; k < 3; k++)
+            {
+                const int index = indices[3 * t + k];
+                if (local[index] < 0)
+                {
+                    local[index] = 1;
+                    used.push_back(index);
+                    vertex_count++;
+                }
+                v[k] = meshlet.mesh_.addVertex(glm::dvec3(vertices[index]));
+            }
+            meshlet.mesh_.addTriangle(v[0], v[1], v[2], colors[t]);
+            assigned[t] = true;
+            count++;
+
+            for (int k = 0; k < 3; k++)
+                for (int n : vertex_triangles[indices[3 * t + k]])
+                    if (!assigned[n])
+                        frontier.push_back(n);
+        }
+
+        for (int index : used)
+            local[index] = -1;
+        used.clear();
+
+        optimizeVertexCache(meshlet.mesh_);
+        meshlet.computeBounds();
+        meshlets.push_back(std::move(meshlet));
+    }
+
+    LOG_INFO << "Meshlets (" << meshlets.size() << ") from triangles (" << triangle_count << ")" << std::endl;
+
+    return meshlets;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "mesh.hpp"
+
+// A small, spatially coherent cluster of triangles with the bounds needed to
+// reject it as a whole: a bounding sphere for the frustum test and a normal
+// cone for the backface test. Each meshlet is a self contained Mesh, so
+// visible meshlets can be transformed and clipped independently.
+class Meshlet
+{
+public:
+    Meshlet();
+
+    const Mesh &getMesh() const;
+
+    const glm::dvec3 &getCenter() const;
+
+    double getRadius() const;
+
+    // model_view takes the meshlet to view space (camera at the origin,
+    // looking down -z). Only uniform scale is supported.
+    bool isVisible(
+        const glm::dmat4 &model_view,
+        const glm::dmat4 &projection) const;
+
+    bool isFrustumCulled(
+        const glm::dmat4 &model_view,
+        const glm::dmat4 &projection) const;
+
+    bool isBackfaceCulled(
+        const glm::dmat4 &model_view) const;
+
+    static std::vector<Meshlet> build(
+        const Mesh &mesh,
+        int max_triangles = MAX_TRIANGLES,
+        int max_vertices = MAX_VERTICES);
+
+private:
+    void computeBounds();
+
+private:
+    Mesh mesh_;
+    glm::dvec3 center_;
+    double radius_;
+    glm::dvec3 cone_axis_;
+    double cone_cutoff_;
+
+    constexpr static int MAX_TRIANGLES = 128;
+    constexpr static int MAX_VERTICES = 96;
+};
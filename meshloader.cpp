@@ -0,0 +1,89 @@
+#include "meshloader.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "mesh.hpp"
+#include "teapot.hpp"
+
+#define LOG_MODULE_NAME ("MeshLoader")
+#include "log.hpp"
+
+void loadTeapot(Mesh &mesh)
+{
+    int triangle_count = teapot_indices.size() / 3;
+    for (int i = 0; i < triangle_count; i++)
+    {
+        int index = 3 * i;
+        mesh.addTriangle(
+            mesh.addVertex(glm::dvec3(
+                teapot_vertices[3 * (teapot_indices[index + 0]) + 0],
+                teapot_vertices[3 * (teapot_indices[index + 0]) + 1],
+                teapot_vertices[3 * (teapot_indices[index + 0]) + 2])),
+            mesh.addVertex(glm::dvec3(
+                teapot_vertices[3 * (teapot_indices[index + 1]) + 0],
+                teapot_vertices[3 * (teapot_indices[index + 1]) + 1],
+                teapot_vertices[3 * (teapot_indices[index + 1]) + 2])),
+            mesh.addVertex(glm::dvec3(
+                teapot_vertices[3 * (teapot_indices[index + 2]) + 0],
+                teapot_vertices[3 * (teapot_indices[index + 2]) + 1],
+                teapot_vertices[3 * (teapot_indices[index + 2]) + 2])),
+            glm::dvec3(1.0, 1.0, 1.0));
+    }
+}
+
+void loadObj(const std::string &path, Mesh &mesh)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        LOG_ERROR << "Failure opening OBJ file. (" << path << ")" << std::endl;
+        throw std::exception();
+    }
+
+    std::vector<glm::dvec3> positions;
+    std::vector<int> face;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        std::istringstream stream(line);
+        std::string type;
+        stream >> type;
+
+        if (type == "v")
+        {
+            glm::dvec3 v;
+            stream >> v.x >> v.y >> v.z;
+            positions.push_back(v);
+        }
+        else if (type == "f")
+        {
+            face.clear();
+            std::string token;
+            while (stream >> token)
+            {
+                // v, v/vt, v//vn or v/vt/vn. Negative indices are relative.
+                int index = std::stoi(token.substr(0, token.find('/')));
+                index = index < 0 ? positions.size() + index : index - 1;
+                if (index < 0 || index >= (int)positions.size())
+                {
+                    LOG_ERROR << "Vertex index out of range in OBJ file. (" << path << ")" << std::endl;
+                    throw std::exception();
+                }
+                face.push_back(mesh.addVertex(positions[index]));
+            }
+
+            for (int i = 2; i < (int)face.size(); i++)
+            {
+                if (face[0] == face[i - 1] || face[i - 1] == face[i] || face[i] == face[0])
+                    continue;
+                mesh.addTriangle(face[0], face[i - 1], face[i], glm::dvec3(1.0, 1.0, 1.0));
+            }
+        }
+    }
+
+    LOG_INFO << "Loaded (" << path << ") triangles (" << mesh.getIndices().size() / 3 << ")" << std::endl;
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <string>
+
+class Mesh;
+
+// Builds the Utah teapot from teapot.hpp.
+void loadTeapot(Mesh &mesh);
+
+// Loads the triangles of a Wavefront OBJ file. Only positions and faces are
+// read; polygons are fanned into triangles.
+void loadObj(const std::string &path, Mesh &mesh);
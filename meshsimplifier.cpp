@@ -0,0 +1,375 @@
+#include "meshsimplifier.hpp"
+
+#include <algorithm>
+#include <map>
+#include <utility>
+
+#include "mesh.hpp"
+
+#define LOG_MODULE_NAME ("MeshSimplifier")
+#include "log.hpp"
+
+namespace
+{
+    // Weight of the planes that pin down open boundaries, relative to the
+    // area weighted face planes. Keeps silhouettes of open meshes (the teapot
+    // has seams) from being eaten away.
+    constexpr double BOUNDARY_WEIGHT = 1000.0;
+
+    // Minimum cosine between a face normal before and after a collapse.
+    constexpr double FLIP_THRESHOLD = 0.2;
+}
+
+MeshSimplifier::Quadric::Quadric() :
+    a()
+{
+}
+
+MeshSimplifier::Quadric::Quadric(const glm::dvec4 &p, double weight)
+{
+    a[0] = weight * p.x * p.x;
+    a[1] = weight * p.x * p.y;
+    a[2] = weight * p.x * p.z;
+    a[3] = weight * p.x * p.w;
+    a[4] = weight * p.y * p.y;
+    a[5] = weight * p.y * p.z;
+    a[6] = weight * p.y * p.w;
+    a[7] = weight * p.z * p.z;
+    a[8] = weight * p.z * p.w;
+    a[9] = weight * p.w * p.w;
+}
+
+MeshSimplifier::Quadric &MeshSimplifier::Quadric::operator+=(const Quadric &rhs)
+{
+    for (int i = 0; i < 10; i++)
+        a[i] += rhs.a[i];
+    return *this;
+}
+
+double MeshSimplifier::Quadric::evaluate(const glm::dvec3 &v) const
+{
+    return
+        a[0] * v.x * v.x + 2.0 * a[1] * v.x * v.y + 2.0 * a[2] * v.x * v.z + 2.0 * a[3] * v.x +
+        a[4] * v.y * v.y + 2.0 * a[5] * v.y * v.z + 2.0 * a[6] * v.y +
+        a[7] * v.z * v.z + 2.0 * a[8] * v.z +
+        a[9];
+}
+
+MeshSimplifier::MeshSimplifier(const Mesh &mesh) :
+    face_count_(0)
+{
+    const auto &vertices = mesh.getVertices();
+    const auto &indices = mesh.getIndices();
+    const auto &colors = mesh.getColors();
+
+    positions_.reserve(vertices.size());
+    for (const auto &v : vertices)
+        positions_.push_back(glm::dvec3(v));
+    quadrics_.resize(positions_.size());
+    versions_.resize(positions_.size(), 0);
+    alive_.resize(positions_.size(), true);
+    vertex_faces_.resize(positions_.size());
+
+    const int triangle_count = indices.size() / 3;
+    faces_.reserve(triangle_count);
+    face_colors_.reserve(triangle_count);
+    face_alive_.reserve(triangle_count);
+
+    // Undirected edge -> (use count, face of first use).
+    std::map<std::pair<int, int>, std::pair<int, int>> edges;
+
+    for (int i = 0; i < triangle_count; i++)
+    {
+        const glm::ivec3 f(indices[3 * i + 0], indices[3 * i + 1], indices[3 * i + 2]);
+        const int face = faces_.size();
+        faces_.push_back(f);
+        face_colors_.push_back(colors[i]);
+        face_alive_.push_back(true);
+        face_count_++;
+
+        const glm::dvec3 &p0 = positions_[f.x];
+        const glm::dvec3 n = glm::cross(positions_[f.y] - p0, positions_[f.z] - p0);
+        const double area2 = glm::length(n);
+        if (area2 > 0.0)
+        {
+            const glm::dvec3 u = n / area2;
+            const Quadric q(glm::dvec4(u, -glm::dot(u, p0)), 0.5 * area2);
+            for (int k = 0; k < 3; k++)
+                quadrics_[f[k]] += q;
+        }
+
+        for (int k = 0; k < 3; k++)
+        {
+            vertex_faces_[f[k]].push_back(face);
+
+            int a = f[k];
+            int b = f[(k + 1) % 3];
+            auto key = a < b ? std::make_pair(a, b) : std::make_pair(b, a);
+            auto it = edges.find(key);
+            if (it == edges.end())
+                edges.emplace(key, std::make_pair(1, face));
+            else
+                it->second.first++;
+        }
+    }
+
+    for (const auto &edge : edges)
+    {
+        if (edge.second.first == 1)
+        {
+            const glm::ivec3 &f = faces_[edge.second.second];
+            const glm::dvec3 &p0 = positions_[f.x];
+            const glm::dvec3 n = glm::cross(positions_[f.y] - p0, positions_[f.z] - p0);
+            const glm::dvec3 &a = positions_[edge.first.first];
+            const glm::dvec3 e = positions_[edge.first.second] - a;
+            const glm::dvec3 c = glm::cross(e, n);
+            const double l = glm::length(c);
+            if (l > 0.0)
+            {
+                const glm::dvec3 u = c / l;
+                const Quadric q(
+                    glm::dvec4(u, -glm::dot(u, a)),
+                    BOUNDARY_WEIGHT * glm::dot(e, e));
+                quadrics_[edge.first.first] += q;
+                quadrics_[edge.first.second] += q;
+            }
+        }
+    }
+
+    for (const auto &edge : edges)
+        pushCollapse(edge.first.first, edge.first.second);
+}
+
+int MeshSimplifier::getTriangleCount() const
+{
+    return face_count_;
+}
+
+bool MeshSimplifier::optimalPosition(const Quadric &q, glm::dvec3 &v) const
+{
+    const double *a = q.a;
+    const double det =
+        a[0] * (a[4] * a[7] - a[5] * a[5]) -
+        a[1] * (a[1] * a[7] - a[5] * a[2]) +
+        a[2] * (a[1] * a[5] - a[4] * a[2]);
+    if (glm::abs(det) < 1e-12)
+        return false;
+
+    const glm::dvec3 r(-a[3], -a[6], -a[8]);
+    v.x = (
+        r.x * (a[4] * a[7] - a[5] * a[5]) -
+        a[1] * (r.y * a[7] - a[5] * r.z) +
+        a[2] * (r.y * a[5] - a[4] * r.z)) / det;
+    v.y = (
+        a[0] * (r.y * a[7] - r.z * a[5]) -
+        r.x * (a[1] * a[7] - a[5] * a[2]) +
+        a[2] * (a[1] * r.z - r.y * a[2])) / det;
+    v.z = (
+        a[0] * (a[4] * r.z - a[5] * r.y) -
+        a[1] * (a[1] * r.z - r.y * a[2]) +
+        r.x * (a[1] * a[5] - a[4] * a[2])) / det;
+    return true;
+}
+
+void MeshSimplifier::pushCollapse(int a, int b)
+{
+    Quadric q = quadrics_[a];
+    q += quadrics_[b];
+
+    const glm::dvec3 &pa = positions_[a];
+    const glm::dvec3 &pb = positions_[b];
+
+    Collapse c;
+    c.a = a;
+    c.b = b;
+    c.version_a = versions_[a];
+    c.version_b = versions_[b];
+
+    // Fall back to the best of the endpoints and the midpoint when the
+    // quadric is singular (flat or linear neighbourhoods).
+    const glm::dvec3 candidates[3] = { pa, pb, 0.5 * (pa + pb) };
+    c.position = candidates[0];
+    c.cost = q.evaluate(candidates[0]);
+    for (int i = 1; i < 3; i++)
+    {
+        double cost = q.evaluate(candidates[i]);
+        if (cost < c.cost)
+        {
+            c.cost = cost;
+            c.position = candidates[i];
+        }
+    }
+
+    glm::dvec3 v;
+    if (optimalPosition(q, v))
+    {
+        double cost = q.evaluate(v);
+        if (cost < c.cost)
+        {
+            c.cost = cost;
+            c.position = v;
+        }
+    }
+
+    c.cost = glm::max(0.0, c.cost);
+    heap_.push(c);
+}
+
+bool MeshSimplifier::flips(int v, int other, const glm::dvec3 &position) const
+{
+    for (int face : vertex_faces_[v])
+    {
+        if (!face_alive_[face])
+            continue;
+
+        const glm::ivec3 &f = faces_[face];
+        if (f.x == other || f.y == other || f.z == other)
+            continue;
+
+        glm::dvec3 p[3] = { positions_[f.x], positions_[f.y], positions_[f.z] };
+        const glm::dvec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+        for (int k = 0; k < 3; k++)
+            if (f[k] == v)
+                p[k] = position;
+        const glm::dvec3 after = glm::cross(p[1] - p[0], p[2] - p[0]);
+
+        const double lb = glm::length(before);
+        const double la = glm::length(after);
+        if (la == 0.0)
+            return true;
+        if (lb > 0.0 && glm::dot(before, after) < FLIP_THRESHOLD * lb * la)
+            return true;
+    }
+    return false;
+}
+
+void MeshSimplifier::collapse(const Collapse &c)
+{
+    const int a = c.a;
+    const int b = c.b;
+
+    positions_[a] = c.position;
+    quadrics_[a] += quadrics_[b];
+
+    for (int face : vertex_faces_[b])
+    {
+        if (!face_alive_[face])
+            continue;
+
+        glm::ivec3 &f = faces_[face];
+        if (f.x == a || f.y == a || f.z == a)
+        {
+            face_alive_[face] = false;
+            face_count_--;
+            continue;
+        }
+
+        for (int k = 0; k < 3; k++)
+            if (f[k] == b)
+                f[k] = a;
+        vertex_faces_[a].push_back(face);
+    }
+
+    alive_[b] = false;
+    vertex_faces_[b].clear();
+    versions_[a]++;
+
+    auto &faces = vertex_faces_[a];
+    faces.erase(
+        std::remove_if(
+            faces.begin(),
+            faces.end(),
+            [this](int face) { return !face_alive_[face]; }),
+        faces.end());
+
+    std::vector<int> neighbours;
+    for (int face : faces)
+        for (int k = 0; k < 3; k++)
+            if (faces_[face][k] != a)
+                neighbours.push_back(faces_[face][k]);
+    std::sort(neighbours.begin(), neighbours.end());
+    neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+
+    for (int n : neighbours)
+        pushCollapse(a, n);
+}
+
+Mesh MeshSimplifier::simplify(int target_triangle_count)
+{
+    std::vector<int> ring_a;
+    std::vector<int> ring_b;
+
+    while (face_count_ > target_triangle_count && !heap_.empty())
+    {
+        Collapse c = heap_.top();
+        heap_.pop();
+
+        if (!alive_[c.a] || !alive_[c.b] ||
+            versions_[c.a] != c.version_a ||
+            versions_[c.b] != c.version_b)
+            continue;
+
+        if (flips(c.a, c.b, c.position) || flips(c.b, c.a, c.position))
+            continue;
+
+        // Link condition: the only vertices adjacent to both ends of the
+        // edge may be the apexes of the faces sharing it. Anything else
+        // would pinch the surface into a non-manifold configuration.
+        int shared_faces = 0;
+        ring_a.clear();
+        ring_b.clear();
+        for (int face : vertex_faces_[c.a])
+        {
+            if (!face_alive_[face])
+                continue;
+            const glm::ivec3 &f = faces_[face];
+            if (f.x == c.b || f.y == c.b || f.z == c.b)
+                shared_faces++;
+            for (int k = 0; k < 3; k++)
+                if (f[k] != c.a)
+                    ring_a.push_back(f[k]);
+        }
+        for (int face : vertex_faces_[c.b])
+        {
+            if (!face_alive_[face])
+                continue;
+            for (int k = 0; k < 3; k++)
+                if (faces_[face][k] != c.b)
+                    ring_b.push_back(faces_[face][k]);
+        }
+        std::sort(ring_a.begin(), ring_a.end());
+        ring_a.erase(std::unique(ring_a.begin(), ring_a.end()), ring_a.end());
+        std::sort(ring_b.begin(), ring_b.end());
+        ring_b.erase(std::unique(ring_b.begin(), ring_b.end()), ring_b.end());
+
+        int common = 0;
+        for (int v : ring_a)
+            if (v != c.b && std::binary_search(ring_b.begin(), ring_b.end(), v))
+                common++;
+        if (common > shared_faces)
+            continue;
+
+        collapse(c);
+    }
+
+    Mesh mesh;
+    for (int i = 0; i < (int)faces_.size(); i++)
+    {
+        if (!face_alive_[i])
+            continue;
+
+        const glm::ivec3 &f = faces_[i];
+        const glm::dvec3 &p0 = positions_[f.x];
+        if (glm::length(glm::cross(positions_[f.y] - p0, positions_[f.z] - p0)) == 0.0)
+            continue;
+
+        int a = mesh.addVertex(positions_[f.x]);
+        int b = mesh.addVertex(positions_[f.y]);
+        int c = mesh.addVertex(positions_[f.z]);
+        if (a == b || b == c || c == a)
+            continue;
+        mesh.addTriangle(a, b, c, face_colors_[i]);
+    }
+
+    return mesh;
+}
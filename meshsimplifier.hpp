@@ -0,0 +1,74 @@
+#pragma once
+
+#include <queue>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+class Mesh;
+
+// Quadric error metric edge-collapse simplifier (Garland & Heckbert).
+// Operates on the welded topology of a Mesh. Successive calls to simplify()
+// keep collapsing from where the previous call stopped, so a whole LOD chain
+// can be produced from a single pass over the source mesh.
+class MeshSimplifier
+{
+public:
+    MeshSimplifier(const Mesh &mesh);
+
+    Mesh simplify(int target_triangle_count);
+
+    int getTriangleCount() const;
+
+private:
+    struct Quadric
+    {
+        Quadric();
+        Quadric(const glm::dvec4 &plane, double weight);
+
+        Quadric &operator+=(const Quadric &rhs);
+
+        double evaluate(const glm::dvec3 &v) const;
+
+        // Upper triangle of the symmetric 4x4 matrix.
+        double a[10];
+    };
+
+    struct Collapse
+    {
+        double cost;
+        int a;
+        int b;
+        int version_a;
+        int version_b;
+        glm::dvec3 position;
+
+        bool operator<(const Collapse &rhs) const
+        {
+            // std::priority_queue is a max-heap.
+            return cost > rhs.cost;
+        }
+    };
+
+    void pushCollapse(int a, int b);
+
+    bool optimalPosition(const Quadric &q, glm::dvec3 &v) const;
+
+    bool flips(int v, int other, const glm::dvec3 &position) const;
+
+    void collapse(const Collapse &c);
+
+private:
+    std::vector<glm::dvec3> positions_;
+    std::vector<Quadric> quadrics_;
+    std::vector<int> versions_;
+    std::vector<bool> alive_;
+    std::vector<std::vector<int>> vertex_faces_;
+
+    std::vector<glm::ivec3> faces_;
+    std::vector<glm::dvec3> face_colors_;
+    std::vector<bool> face_alive_;
+    int face_count_;
+
+    std::priority_queue<Collapse> heap_;
+};
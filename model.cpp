@@ -0,0 +1,23 @@
+#include "model.hpp"
+
+#define LOG_MODULE_NAME ("Model")
+#include "log.hpp"
+
+Model::Model(const Mesh &mesh) :
+    lod_chain_(mesh)
+{
+    LOG_INFO << "Instance created." << std::endl;
+
+    for (int i = 0; i < lod_chain_.getLevelCount(); i++)
+        meshlets_.push_back(Meshlet::build(lod_chain_.getLevel(i)));
+}
+
+const LodChain &Model::getLodChain() const
+{
+    return lod_chain_;
+}
+
+const std::vector<Meshlet> &Model::getMeshlets(int level) const
+{
+    return meshlets_[level];
+}
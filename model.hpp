@@ -0,0 +1,24 @@
+#pragma once
+
+#include <vector>
+
+#include "lodchain.hpp"
+#include "meshlet.hpp"
+
+class Mesh;
+
+// Renderable geometry shared by any number of scene objects: the LOD chain
+// of a mesh and the meshlets of every level.
+class Model
+{
+public:
+    Model(const Mesh &mesh);
+
+    const LodChain &getLodChain() const;
+
+    const std::vector<Meshlet> &getMeshlets(int level) const;
+
+private:
+    LodChain lod_chain_;
+    std::vector<std::vector<Meshlet>> meshlets_;
+};
@@ -0,0 +1,231 @@
+#include "occlusionculler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define OCCLUSION_SSE2
+#endif
+
+#include "framebuffer.hpp"
+#include "mesh.hpp"
+
+#define LOG_MODULE_NAME ("OcclusionCuller")
+#include "log.hpp"
+
+OcclusionCuller::OcclusionCuller(int width, int height) :
+    width_(width),
+    height_(height),
+    view_projection_(1.0),
+    depth_((size_t)width * height, std::numeric_limits<float>::max()),
+    stats_()
+{
+}
+
+void OcclusionCuller::begin(const glm::dmat4 &view_projection)
+{
+    view_projection_ = view_projection;
+    std::fill(depth_.begin(), depth_.end(), std::numeric_limits<float>::max());
+    stats_ = Stats();
+}
+
+const OcclusionCuller::Stats &OcclusionCuller::getStats() const
+{
+    return stats_;
+}
+
+void OcclusionCuller::renderOccluder(const Mesh &mesh, const glm::dmat4 &transform)
+{
+    const glm::dmat4 m = view_projection_ * transform;
+    const auto &vertices = mesh.getVertices();
+    const auto &indices = mesh.getIndices();
+
+    screen_.resize(vertices.size());
+    for (int i = 0; i < (int)vertices.size(); i++)
+    {
+        const glm::dvec4 p = m * vertices[i];
+        if (p.w < NEAR)
+        {
+            screen_[i] = glm::vec3(0.0f, 0.0f, -1.0f);
+            continue;
+        }
+        screen_[i] = glm::vec3(
+            (float)((p.x / p.w * 0.5 + 0.5) * width_),
+            (float)((p.y / p.w * 0.5 + 0.5) * height_),
+            (float)p.w);
+    }
+
+    stats_.occluders++;
+    for (int i = 0; i < (int)indices.size() / 3; i++)
+    {
+        const glm::vec3 &a = screen_[indices[3 * i + 0]];
+        const glm::vec3 &b = screen_[indices[3 * i + 1]];
+        const glm::vec3 &c = screen_[indices[3 * i + 2]];
+
+        // Triangles crossing the near plane are dropped rather than clipped;
+        // leaving out occluder area is always safe.
+        if (a.z < 0.0f || b.z < 0.0f || c.z < 0.0f)
+            continue;
+
+        // Front faces are counter clockwise with y up.
+        if ((b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x) <= 0.0f)
+            continue;
+
+        stats_.occluder_triangles++;
+        rasterize(
+            glm::vec2(a.x, a.y),
+            glm::vec2(b.x, b.y),
+            glm::vec2(c.x, c.y),
+            std::max(a.z, std::max(b.z, c.z)));
+    }
+}
+
+void OcclusionCuller::rasterize(
+    const glm::vec2 &a,
+    const glm::vec2 &b,
+    const glm::vec2 &c,
+    float depth)
+{
+    const int x0 = std::max(0, (int)std::floor(std::min(a.x, std::min(b.x, c.x))));
+    const int x1 = std::min(width_ - 1, (int)std::ceil(std::max(a.x, std::max(b.x, c.x))));
+    const int y0 = std::max(0, (int)std::floor(std::min(a.y, std::min(b.y, c.y))));
+    const int y1 = std::min(height_ - 1, (int)std::ceil(std::max(a.y, std::max(b.y, c.y))));
+    if (x0 > x1 || y0 > y1)
+        return;
+
+    // Edge functions, positive inside, evaluated at pixel centres.
+    const glm::vec2 v[3] = { a, b, c };
+    float dx[3];
+    float dy[3];
+    float row[3];
+    for (int k = 0; k < 3; k++)
+    {
+        const glm::vec2 &p = v[k];
+        const glm::vec2 &q = v[(k + 1) % 3];
+        dx[k] = -(q.y - p.y);
+        dy[k] = q.x - p.x;
+        row[k] = dy[k] * (y0 + 0.5f - p.y) + dx[k] * (x0 + 0.5f - p.x);
+    }
+
+    for (int y = y0; y <= y1; y++)
+    {
+        float *line = &depth_[(size_t)y * width_];
+        float e0 = row[0];
+        float e1 = row[1];
+        float e2 = row[2];
+        int x = x0;
+
+#ifdef OCCLUSION_SSE2
+        const __m128 step = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 z = _mm_set1_ps(depth);
+        __m128 s0 = _mm_add_ps(_mm_set1_ps(e0), _mm_mul_ps(step, _mm_set1_ps(dx[0])));
+        __m128 s1 = _mm_add_ps(_mm_set1_ps(e1), _mm_mul_ps(step, _mm_set1_ps(dx[1])));
+        __m128 s2 = _mm_add_ps(_mm_set1_ps(e2), _mm_mul_ps(step, _mm_set1_ps(dx[2])));
+        const __m128 d0 = _mm_set1_ps(4.0f * dx[0]);
+        const __m128 d1 = _mm_set1_ps(4.0f * dx[1]);
+        const __m128 d2 = _mm_set1_ps(4.0f * dx[2]);
+        for (; x + 3 <= x1; x += 4)
+        {
+            const __m128 inside = _mm_and_ps(
+                _mm_cmpge_ps(s0, zero),
+                _mm_and_ps(_mm_cmpge_ps(s1, zero), _mm_cmpge_ps(s2, zero)));
+            const __m128 old = _mm_loadu_ps(line + x);
+            const __m128 nearer = _mm_min_ps(old, z);
+            _mm_storeu_ps(
+                line + x,
+                _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, old)));
+            s0 = _mm_add_ps(s0, d0);
+            s1 = _mm_add_ps(s1, d1);
+            s2 = _mm_add_ps(s2, d2);
+        }
+        e0 += (x - x0) * dx[0];
+        e1 += (x - x0) * dx[1];
+        e2 += (x - x0) * dx[2];
+#endif
+
+        for (; x <= x1; x++)
+        {
+            if (e0 >= 0.0f && e1 >= 0.0f && e2 >= 0.0f)
+                line[x] = std::min(line[x], depth);
+            e0 += dx[0];
+            e1 += dx[1];
+            e2 += dx[2];
+        }
+
+        for (int k = 0; k < 3; k++)
+            row[k] += dy[k];
+    }
+}
+
+bool OcclusionCuller::isVisible(const Aabb &box)
+{
+    stats_.occludees_tested++;
+
+    glm::vec2 lo(std::numeric_limits<float>::max());
+    glm::vec2 hi(-std::numeric_limits<float>::max());
+    double nearest = std::numeric_limits<double>::max();
+    for (int i = 0; i < 8; i++)
+    {
+        const glm::dvec3 corner(
+            (i & 1) ? box.hi.x : box.lo.x,
+            (i & 2) ? box.hi.y : box.lo.y,
+            (i & 4) ? box.hi.z : box.lo.z);
+        const glm::dvec4 p = view_projection_ * glm::dvec4(corner, 1.0);
+
+        // Reaches behind the near plane; cannot be hidden.
+        if (p.w < NEAR)
+            return true;
+
+        const glm::vec2 s(
+            (float)((p.x / p.w * 0.5 + 0.5) * width_),
+            (float)((p.y / p.w * 0.5 + 0.5) * height_));
+        lo = glm::min(lo, s);
+        hi = glm::max(hi, s);
+        nearest = std::min(nearest, p.w);
+    }
+
+    const int x0 = std::max(0, (int)std::floor(lo.x));
+    const int x1 = std::min(width_ - 1, (int)std::ceil(hi.x));
+    const int y0 = std::max(0, (int)std::floor(lo.y));
+    const int y1 = std::min(height_ - 1, (int)std::ceil(hi.y));
+    if (x0 > x1 || y0 > y1)
+        return true;
+
+    const float z = (float)nearest;
+    for (int y = y0; y <= y1; y++)
+    {
+        const float *line = &depth_[(size_t)y * width_];
+        for (int x = x0; x <= x1; x++)
+            if (line[x] >= z)
+                return true;
+    }
+
+    stats_.occludees_culled++;
+    return false;
+}
+
+void OcclusionCuller::drawDebug(FramebufferView &framebuffer) const
+{
+    constexpr float RANGE = 100.0f;
+    const int width = framebuffer.getWidth();
+    const int height = framebuffer.getHeight();
+    std::vector<uint32_t> row(width);
+    for (int y = 0; y < height; y++)
+    {
+        // Framebuffer rows run top down, the depth buffer bottom up.
+        const int by = (height - 1 - y) * height_ / height;
+        const float *line = &depth_[(size_t)by * width_];
+        for (int x = 0; x < width; x++)
+        {
+            const float d = line[x * width_ / width];
+            const double l = d == std::numeric_limits<float>::max() ?
+                0.0 :
+                1.0 - std::min(1.0f, d / RANGE);
+            row[x] = packPixel(framebuffer.getFormat(), glm::dvec3(l));
+        }
+        framebuffer.writeSpan(y, 0, width, row.data());
+    }
+}
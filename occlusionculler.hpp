@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "bvh.hpp"
+
+class FramebufferView;
+class Mesh;
+
+// Software occlusion culling in the spirit of Intel's Masked Occlusion
+// Culling. Occluders are rasterized into a small depth buffer that keeps, per
+// pixel, the nearest of the furthest depths of the triangles covering it;
+// an object is hidden when every pixel under its screen bounds holds an
+// occluder closer than the object's nearest point. Depth is clip space w,
+// i.e. linear distance along the view axis.
+class OcclusionCuller
+{
+public:
+    struct Stats
+    {
+        int occluders;
+        int occluder_triangles;
+        int occludees_tested;
+        int occludees_culled;
+    };
+
+    OcclusionCuller(int width = WIDTH, int height = HEIGHT);
+
+    // Clears the depth buffer and statistics for a new frame.
+    void begin(const glm::dmat4 &view_projection);
+
+    void renderOccluder(const Mesh &mesh, const glm::dmat4 &transform);
+
+    bool isVisible(const Aabb &box);
+
+    const Stats &getStats() const;
+
+    // Draws the depth buffer as a grey ramp (near is bright) scaled up over
+    // the whole framebuffer, one span per row.
+    void drawDebug(FramebufferView &framebuffer) const;
+
+private:
+    void rasterize(
+        const glm::vec2 &a,
+        const glm::vec2 &b,
+        const glm::vec2 &c,
+        float depth);
+
+private:
+    int width_;
+    int height_;
+    glm::dmat4 view_projection_;
+    std::vector<float> depth_;
+    std::vector<glm::vec3> screen_;
+    Stats stats_;
+
+    constexpr static int WIDTH = 320;
+    constexpr static int HEIGHT = 192;
+    constexpr static double NEAR = 0.1;
+};
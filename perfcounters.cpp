@@ -0,0 +1,228 @@
+#include "perfcounters.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#define LOG_MODULE_NAME ("PerfCounters")
+#include "log.hpp"
+
+namespace
+{
+    // One counter group per thread, led by its cycle counter so all of
+    // them are scheduled together and come back with one read().
+    struct Group
+    {
+        int tid;
+        int leader;
+        // Position of each counter in the group's read() result, or -1.
+        std::array<int, PerfCounters::COUNTER_COUNT> slots;
+        std::array<int, PerfCounters::COUNTER_COUNT> fds;
+        int size;
+    };
+
+    std::mutex groups_mutex;
+    std::vector<Group> groups;
+    std::atomic<bool> opened(false);
+    std::array<bool, PerfCounters::COUNTER_COUNT> available = {};
+
+#ifdef __linux__
+    void configure(PerfCounters::Counter counter, perf_event_attr &attr)
+    {
+        switch (counter)
+        {
+        case PerfCounters::CYCLES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case PerfCounters::INSTRUCTIONS:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case PerfCounters::LLC_MISSES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+        case PerfCounters::BRANCH_MISSES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        case PerfCounters::DTLB_MISSES:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config =
+                PERF_COUNT_HW_CACHE_DTLB |
+                (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            break;
+        default:
+            break;
+        }
+    }
+
+    int openEvent(PerfCounters::Counter counter, int tid, int group_fd)
+    {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        configure(counter, attr);
+        attr.read_format =
+            PERF_FORMAT_GROUP |
+            PERF_FORMAT_TOTAL_TIME_ENABLED |
+            PERF_FORMAT_TOTAL_TIME_RUNNING;
+        // User space only, which is all an unprivileged process may count
+        // at the default paranoia level.
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        return (int)syscall(SYS_perf_event_open, &attr, tid, -1, group_fd, 0);
+    }
+
+    // Opens a group for the thread. Returns false, and leaves the group
+    // empty, if not even the cycle counter can be opened.
+    bool openGroup(Group &group)
+    {
+        group.slots.fill(-1);
+        group.fds.fill(-1);
+        group.size = 0;
+        group.leader = openEvent(PerfCounters::CYCLES, group.tid, -1);
+        if (group.leader < 0)
+            return false;
+        group.fds[PerfCounters::CYCLES] = group.leader;
+        group.slots[PerfCounters::CYCLES] = group.size++;
+
+        for (int i = PerfCounters::CYCLES + 1; i < PerfCounters::COUNTER_COUNT; i++)
+        {
+            const int fd = openEvent((PerfCounters::Counter)i, group.tid, group.leader);
+            if (fd < 0)
+                continue;
+            group.fds[i] = fd;
+            group.slots[i] = group.size++;
+        }
+        return true;
+    }
+#endif
+}
+
+void PerfCounters::registerThread()
+{
+#ifdef __linux__
+    thread_local bool registered = false;
+    if (registered)
+        return;
+    registered = true;
+
+    std::lock_guard<std::mutex> lock(groups_mutex);
+    Group group;
+    group.tid = (int)syscall(SYS_gettid);
+    group.leader = -1;
+    group.slots.fill(-1);
+    group.fds.fill(-1);
+    group.size = 0;
+    if (opened)
+        openGroup(group);
+    groups.push_back(group);
+#endif
+}
+
+bool PerfCounters::open()
+{
+#ifdef __linux__
+    std::lock_guard<std::mutex> lock(groups_mutex);
+    if (opened)
+        return true;
+
+    // Probe on the calling thread first, so a missing PMU or permission
+    // gives one warning and not one per thread.
+    Group probe;
+    probe.tid = 0;
+    if (!openGroup(probe))
+    {
+        LOG_WARNING << "Failure in perf_event_open, hardware counters disabled. (" << std::strerror(errno) << ")" << std::endl;
+        return false;
+    }
+    for (int i = 0; i < COUNTER_COUNT; i++)
+    {
+        available[i] = probe.fds[i] >= 0;
+        if (probe.fds[i] >= 0)
+            close(probe.fds[i]);
+        if (!available[i])
+            LOG_WARNING << "Failure in perf_event_open, counter unavailable. (" << getCounterName((Counter)i) << ")" << std::endl;
+    }
+
+    for (Group &group : groups)
+        openGroup(group);
+    opened = true;
+    LOG_INFO << "Counters opened. (" << groups.size() << " threads)" << std::endl;
+    return true;
+#else
+    LOG_WARNING << "Failure in opening hardware counters, only supported on Linux." << std::endl;
+    return false;
+#endif
+}
+
+bool PerfCounters::isOpen()
+{
+    return opened;
+}
+
+bool PerfCounters::isAvailable(Counter counter)
+{
+    return opened && available[counter];
+}
+
+void PerfCounters::read(Sample &sample)
+{
+    sample = Sample();
+#ifdef __linux__
+    if (!opened)
+        return;
+
+    std::lock_guard<std::mutex> lock(groups_mutex);
+    // nr, time enabled, time running, then one value per counter.
+    uint64_t buffer[3 + COUNTER_COUNT];
+    for (const Group &group : groups)
+    {
+        if (group.leader < 0)
+            continue;
+        if (::read(group.leader, buffer, sizeof(buffer)) < (ssize_t)(3 * sizeof(uint64_t)))
+            continue;
+
+        // Raw counts; Sample::operator- scales the interval between reads.
+        sample.enabled += buffer[1];
+        sample.running += buffer[2];
+        for (int i = 0; i < COUNTER_COUNT; i++)
+        {
+            if (group.slots[i] < 0)
+                continue;
+            sample.values[i] += buffer[3 + group.slots[i]];
+        }
+    }
+#endif
+}
+
+const char *PerfCounters::getCounterName(Counter counter)
+{
+    switch (counter)
+    {
+    case CYCLES:
+        return "cycles";
+    case INSTRUCTIONS:
+        return "instructions";
+    case LLC_MISSES:
+        return "llc_misses";
+    case BRANCH_MISSES:
+        return "branch_misses";
+    case DTLB_MISSES:
+        return "dtlb_misses";
+    default:
+        return "unknown";
+    }
+}
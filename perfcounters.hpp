@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// Hardware event counters through Linux perf_event_open: cycles,
+// instructions, last level cache misses, branch misses and data TLB misses
+// of every registered thread, user space only.
+//
+// Threads register when they start; nothing is counted until open(). Where
+// counters cannot be opened (other platforms, containers, a restrictive
+// perf_event_paranoid, virtual machines without a PMU) open() warns once
+// and returns false, and everything keeps working with zero samples.
+class PerfCounters
+{
+public:
+    enum Counter
+    {
+        CYCLES,
+        INSTRUCTIONS,
+        LLC_MISSES,
+        BRANCH_MISSES,
+        DTLB_MISSES,
+        COUNTER_COUNT
+    };
+
+    // Event counts of every counted thread, summed. read() gives raw
+    // totals; the difference of two reads gives the events in between,
+    // scaled up where the kernel had to multiplex the counters. Scaling the
+    // interval rather than the totals keeps differences from going
+    // negative when the multiplexing ratio changes between reads.
+    struct Sample
+    {
+        Sample() :
+            values(),
+            enabled(0),
+            running(0)
+        {
+        }
+
+        Sample &operator+=(const Sample &rhs)
+        {
+            for (int i = 0; i < COUNTER_COUNT; i++)
+                values[i] += rhs.values[i];
+            enabled += rhs.enabled;
+            running += rhs.running;
+            return *this;
+        }
+
+        Sample operator-(const Sample &rhs) const
+        {
+            // One ratio for all threads; their groups are multiplexed
+            // alike closely enough for per-stage rates.
+            const uint64_t enabled_delta = enabled - rhs.enabled;
+            const uint64_t running_delta = running - rhs.running;
+            const double scale = running_delta > 0 && running_delta < enabled_delta ?
+                (double)enabled_delta / running_delta :
+                1.0;
+
+            Sample result;
+            for (int i = 0; i < COUNTER_COUNT; i++)
+                result.values[i] = (uint64_t)((values[i] - rhs.values[i]) * scale);
+            return result;
+        }
+
+        std::array<uint64_t, COUNTER_COUNT> values;
+        // Nanoseconds the counters were enabled and actually counting, summed
+        // over threads. Zero in differences, which come scaled already.
+        uint64_t enabled;
+        uint64_t running;
+    };
+
+    // Adds the calling thread to the counted ones; only the first call per
+    // thread does anything. Threads registering after open() are opened
+    // right away.
+    static void registerThread();
+
+    // Opens the counters of every registered thread.
+    static bool open();
+
+    static bool isOpen();
+
+    // False for counters the hardware or kernel does not offer; their
+    // values stay zero.
+    static bool isAvailable(Counter counter);
+
+    // Current totals since open(). One read() per counted thread; take
+    // differences of two samples for a stage.
+    static void read(Sample &sample);
+
+    static const char *getCounterName(Counter counter);
+};
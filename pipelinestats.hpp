@@ -0,0 +1,55 @@
+#pragma once
+
+// What one frame pushed through the pipeline. Every job or thread fills a
+// copy of its own and the copies are summed once the frame is done, so the
+// counters never contend.
+struct alignas(64) PipelineStats
+{
+    PipelineStats() :
+        input_triangles(0),
+        backfaces(0),
+        rejected_triangles(0),
+        clipped_triangles(0),
+        emitted_triangles(0),
+        fragments(0),
+        depth_passed(0),
+        depth_failed(0),
+        written_pixels(0),
+        cleared_pixels(0)
+    {
+    }
+
+    PipelineStats &operator+=(const PipelineStats &rhs)
+    {
+        input_triangles += rhs.input_triangles;
+        backfaces += rhs.backfaces;
+        rejected_triangles += rhs.rejected_triangles;
+        clipped_triangles += rhs.clipped_triangles;
+        emitted_triangles += rhs.emitted_triangles;
+        fragments += rhs.fragments;
+        depth_passed += rhs.depth_passed;
+        depth_failed += rhs.depth_failed;
+        written_pixels += rhs.written_pixels;
+        cleared_pixels += rhs.cleared_pixels;
+        return *this;
+    }
+
+    // Mesh::clip(): triangles going in, dropped as back facing, dropped
+    // entirely outside a frustum plane, cut by a plane (once per cut), and
+    // coming out.
+    long long input_triangles;
+    long long backfaces;
+    long long rejected_triangles;
+    long long clipped_triangles;
+    long long emitted_triangles;
+
+    // Rasterizer: pixels covered by triangles and how the depth test went.
+    long long fragments;
+    long long depth_passed;
+    long long depth_failed;
+
+    // Color stores of any kind: clears, depth test passes and overlays.
+    long long written_pixels;
+    // The part of written_pixels that was cleared.
+    long long cleared_pixels;
+};
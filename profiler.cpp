@@ -0,0 +1,370 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+
+#include "trace.hpp"
+
+#define LOG_MODULE_NAME ("Profiler")
+#include "log.hpp"
+
+Profiler::Profiler() :
+    rows_(WINDOW),
+    row_frames_(WINDOW, -1),
+    frame_(-1),
+    histograms_()
+{
+    scratch_.reserve(WINDOW);
+    LOG_INFO << "Instance created." << std::endl;
+}
+
+void Profiler::beginFrame()
+{
+    frame_++;
+    const int index = frame_ % WINDOW;
+    rows_[index].fill(-1.0);
+    row_frames_[index] = -1;
+    frame_start_ = Clock::now();
+}
+
+void Profiler::endFrame()
+{
+    if (frame_ < 0)
+        return;
+
+    record(FRAME, frame_start_);
+    TRACE_FRAME(frame_);
+
+    const int index = frame_ % WINDOW;
+    const Row &row = rows_[index];
+    for (int stage = 0; stage < STAGE_COUNT; stage++)
+    {
+        if (row[stage] < 0.0)
+            continue;
+        const double us = 1000.0 * row[stage];
+        int bucket = 0;
+        while (bucket < BUCKET_COUNT - 1 && us >= (double)(2ll << bucket))
+            bucket++;
+        histograms_[stage][bucket]++;
+    }
+    row_frames_[index] = frame_;
+}
+
+void Profiler::discardFrame()
+{
+    if (frame_ < 0)
+        return;
+
+    // The next beginFrame() reuses the row.
+    frame_--;
+}
+
+void Profiler::record(Stage stage, double ms)
+{
+    if (frame_ < 0)
+        return;
+
+    double &time = rows_[frame_ % WINDOW][stage];
+    time = time < 0.0 ? ms : time + ms;
+}
+
+void Profiler::record(Stage stage, Clock::time_point start)
+{
+    const Clock::time_point end = Clock::now();
+    TRACE_COMPLETE(getStageName(stage), start, end);
+    record(stage, std::chrono::duration<double, std::milli>(end - start).count());
+}
+
+void Profiler::recordCounters(Stage stage, const PerfCounters::Sample &sample, long long units)
+{
+    counters_[stage].sample += sample;
+    counters_[stage].units += units;
+}
+
+void Profiler::recordAllocations(Stage stage, const AllocTracker::Counts &counts)
+{
+    allocations_[stage].counts += counts;
+    allocations_[stage].frames++;
+    if (counts.allocations > 0)
+        allocations_[stage].allocating_frames++;
+}
+
+const Profiler::Counters &Profiler::getCounters(Stage stage) const
+{
+    return counters_[stage];
+}
+
+const Profiler::Allocations &Profiler::getAllocations(Stage stage) const
+{
+    return allocations_[stage];
+}
+
+Profiler::Summary Profiler::getSummary(Stage stage) const
+{
+    scratch_.clear();
+    for (int i = 0; i < WINDOW; i++)
+        if (row_frames_[i] >= 0 && rows_[i][stage] >= 0.0)
+            scratch_.push_back(rows_[i][stage]);
+
+    Summary summary = {};
+    summary.count = scratch_.size();
+    if (scratch_.empty())
+        return summary;
+
+    std::sort(scratch_.begin(), scratch_.end());
+    // Nearest rank.
+    auto percentile = [this](double p)
+    {
+        const int rank = (int)std::ceil(p * scratch_.size());
+        return scratch_[std::max(0, std::min((int)scratch_.size() - 1, rank - 1))];
+    };
+    summary.p50_ms = percentile(0.50);
+    summary.p95_ms = percentile(0.95);
+    summary.p99_ms = percentile(0.99);
+    summary.max_ms = scratch_.back();
+    return summary;
+}
+
+void Profiler::writeCsv(const std::string &path) const
+{
+    std::ofstream out(path);
+    if (!out)
+    {
+        LOG_ERROR << "Failure in opening profile file. (" << path << ")" << std::endl;
+        throw std::exception();
+    }
+
+    out << "frame";
+    for (int stage = 0; stage < STAGE_COUNT; stage++)
+        out << "," << getStageName((Stage)stage) << "_ms";
+    out << "\n";
+
+    out << std::fixed << std::setprecision(4);
+    // Oldest first.
+    for (int i = 1; i <= WINDOW; i++)
+    {
+        const int index = (frame_ + i) % WINDOW;
+        if (row_frames_[index] < 0)
+            continue;
+        out << row_frames_[index];
+        for (int stage = 0; stage < STAGE_COUNT; stage++)
+        {
+            out << ",";
+            if (rows_[index][stage] >= 0.0)
+                out << rows_[index][stage];
+        }
+        out << "\n";
+    }
+}
+
+void Profiler::writeJson(const std::string &path) const
+{
+    std::ofstream out(path);
+    if (!out)
+    {
+        LOG_ERROR << "Failure in opening profile file. (" << path << ")" << std::endl;
+        throw std::exception();
+    }
+
+    out << std::fixed << std::setprecision(4);
+    out << "{\n";
+    out << "  \"frames\": " << frame_ + 1 << ",\n";
+    out << "  \"window\": " << WINDOW << ",\n";
+    out << "  \"histogram_buckets_us\": [";
+    for (int bucket = 0; bucket < BUCKET_COUNT; bucket++)
+        out << (bucket ? ", " : "") << (bucket ? (1ll << bucket) : 0ll);
+    out << "],\n";
+    out << "  \"stages\": [";
+    for (int stage = 0; stage < STAGE_COUNT; stage++)
+    {
+        const Summary summary = getSummary((Stage)stage);
+        out << (stage ? ",\n" : "\n");
+        out << "    { \"name\": \"" << getStageName((Stage)stage) << "\""
+            << ", \"count\": " << summary.count
+            << ", \"p50_ms\": " << summary.p50_ms
+            << ", \"p95_ms\": " << summary.p95_ms
+            << ", \"p99_ms\": " << summary.p99_ms
+            << ", \"max_ms\": " << summary.max_ms
+            << ", \"histogram\": [";
+        for (int bucket = 0; bucket < BUCKET_COUNT; bucket++)
+            out << (bucket ? ", " : "") << histograms_[stage][bucket];
+        out << "]";
+
+        const Counters &counters = counters_[stage];
+        if (counters.sample.values[PerfCounters::CYCLES] > 0)
+        {
+            const double units = (double)std::max(1ll, counters.units);
+            const double cycles = (double)counters.sample.values[PerfCounters::CYCLES];
+            out << ", \"counters\": { \"unit\": \"" << getStageUnit((Stage)stage) << "\""
+                << ", \"units\": " << counters.units
+                << ", \"ipc\": ";
+            if (PerfCounters::isAvailable(PerfCounters::INSTRUCTIONS))
+                out << counters.sample.values[PerfCounters::INSTRUCTIONS] / cycles;
+            else
+                out << "null";
+            // Unavailable counters are null rather than a misleading zero.
+            for (int i = 0; i < PerfCounters::COUNTER_COUNT; i++)
+            {
+                const char *name = PerfCounters::getCounterName((PerfCounters::Counter)i);
+                if (!PerfCounters::isAvailable((PerfCounters::Counter)i))
+                {
+                    out << ", \"" << name << "\": null, \"" << name << "_per_unit\": null";
+                    continue;
+                }
+                out << ", \"" << name << "\": " << counters.sample.values[i]
+                    << ", \"" << name << "_per_unit\": " << counters.sample.values[i] / units;
+            }
+            out << " }";
+        }
+
+        if (AllocTracker::isEnabled())
+        {
+            const Allocations &allocations = allocations_[stage];
+            out << ", \"allocations\": { \"count\": " << allocations.counts.allocations
+                << ", \"bytes\": " << allocations.counts.bytes
+                << ", \"frames\": " << allocations.frames
+                << ", \"allocating_frames\": " << allocations.allocating_frames
+                << " }";
+        }
+        out << " }";
+    }
+    out << "\n  ]\n}\n";
+}
+
+void Profiler::writeCounters(std::ostream &out) const
+{
+    out << std::left
+        << std::setw(12) << "stage"
+        << std::setw(10) << "unit"
+        << std::right
+        << std::setw(8) << "ipc"
+        << std::setw(14) << "cycles/unit"
+        << std::setw(14) << "llc/unit"
+        << std::setw(14) << "branch/unit"
+        << std::setw(14) << "dtlb/unit"
+        << "\n";
+
+    for (int stage = 0; stage < STAGE_COUNT; stage++)
+    {
+        const Counters &counters = counters_[stage];
+        if (counters.sample.values[PerfCounters::CYCLES] == 0)
+            continue;
+
+        const double units = (double)std::max(1ll, counters.units);
+        auto perUnit = [&](PerfCounters::Counter counter) -> std::string
+        {
+            if (!PerfCounters::isAvailable(counter))
+                return "n/a";
+            char buffer[32];
+            snprintf(buffer, sizeof(buffer), "%.4f", counters.sample.values[counter] / units);
+            return buffer;
+        };
+        std::string ipc = "n/a";
+        if (PerfCounters::isAvailable(PerfCounters::INSTRUCTIONS))
+        {
+            char buffer[32];
+            snprintf(
+                buffer,
+                sizeof(buffer),
+                "%.2f",
+                (double)counters.sample.values[PerfCounters::INSTRUCTIONS] /
+                    counters.sample.values[PerfCounters::CYCLES]);
+            ipc = buffer;
+        }
+
+        out << std::left
+            << std::setw(12) << getStageName((Stage)stage)
+            << std::setw(10) << getStageUnit((Stage)stage)
+            << std::right
+            << std::setw(8) << ipc
+            << std::setw(14) << perUnit(PerfCounters::CYCLES)
+            << std::setw(14) << perUnit(PerfCounters::LLC_MISSES)
+            << std::setw(14) << perUnit(PerfCounters::BRANCH_MISSES)
+            << std::setw(14) << perUnit(PerfCounters::DTLB_MISSES)
+            << "\n";
+    }
+}
+
+void Profiler::writeAllocations(std::ostream &out) const
+{
+    out << std::left
+        << std::setw(12) << "stage"
+        << std::right
+        << std::setw(14) << "allocs/frame"
+        << std::setw(14) << "bytes/frame"
+        << std::setw(18) << "allocating frames"
+        << "\n";
+
+    for (int stage = 0; stage < STAGE_COUNT; stage++)
+    {
+        const Allocations &allocations = allocations_[stage];
+        if (allocations.frames == 0)
+            continue;
+
+        const double frames = (double)allocations.frames;
+        char per_frame[32];
+        char bytes_per_frame[32];
+        char allocating[32];
+        snprintf(per_frame, sizeof(per_frame), "%.1f", allocations.counts.allocations / frames);
+        snprintf(bytes_per_frame, sizeof(bytes_per_frame), "%.0f", allocations.counts.bytes / frames);
+        snprintf(allocating, sizeof(allocating), "%lld/%lld", allocations.allocating_frames, allocations.frames);
+        out << std::left
+            << std::setw(12) << getStageName((Stage)stage)
+            << std::right
+            << std::setw(14) << per_frame
+            << std::setw(14) << bytes_per_frame
+            << std::setw(18) << allocating
+            << "\n";
+    }
+}
+
+const char *Profiler::getStageUnit(Stage stage)
+{
+    switch (stage)
+    {
+    case CULL:
+    case TRANSFORM:
+    case CLIP:
+        return "triangle";
+    case CLEAR:
+        return "pixel";
+    case RASTERIZE:
+        return "fragment";
+    default:
+        return "frame";
+    }
+}
+
+const char *Profiler::getStageName(Stage stage)
+{
+    switch (stage)
+    {
+    case EVENTS:
+        return "events";
+    case CONTROLLERS:
+        return "controllers";
+    case CULL:
+        return "cull";
+    case TRANSFORM:
+        return "transform";
+    case CLIP:
+        return "clip";
+    case CLEAR:
+        return "clear";
+    case RASTERIZE:
+        return "rasterize";
+    case UPLOAD:
+        return "upload";
+    case PRESENT:
+        return "present";
+    case FRAME:
+        return "frame";
+    case LATENCY:
+        return "latency";
+    default:
+        return "unknown";
+    }
+}
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "alloctracker.hpp"
+#include "perfcounters.hpp"
+
+// Per-stage frame timings, cheap enough to leave on: timing a stage is two
+// clock reads and an add into a fixed ring of rows. Percentiles are worked
+// out over the last WINDOW frames only when asked for; histograms with
+// power of two microsecond buckets cover the whole run, as do hardware
+// counter totals when PerfCounters are open and allocation totals when
+// AllocTracker is compiled in.
+class Profiler
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum Stage
+    {
+        EVENTS,
+        CONTROLLERS,
+        CULL,
+        TRANSFORM,
+        CLIP,
+        CLEAR,
+        RASTERIZE,
+        UPLOAD,
+        PRESENT,
+        // Whole frames, from beginFrame() to endFrame().
+        FRAME,
+        // Input to photon, not part of the frame time: from the oldest
+        // input event a frame is the first to reflect until presenting it
+        // returned. Only frames that reflect new input have it.
+        LATENCY,
+        STAGE_COUNT
+    };
+
+    struct Summary
+    {
+        // Frames in the window that ran the stage.
+        int count;
+        double p50_ms;
+        double p95_ms;
+        double p99_ms;
+        double max_ms;
+    };
+
+    // Hardware counter totals of a stage over the whole run, and the units
+    // of work they went into, see getStageUnit().
+    struct Counters
+    {
+        Counters() :
+            units(0)
+        {
+        }
+
+        PerfCounters::Sample sample;
+        long long units;
+    };
+
+    // Heap allocations of a stage over the whole run, the frames recorded
+    // and how many of them allocated at all; a steady state should have
+    // none.
+    struct Allocations
+    {
+        Allocations() :
+            frames(0),
+            allocating_frames(0)
+        {
+        }
+
+        AllocTracker::Counts counts;
+        long long frames;
+        long long allocating_frames;
+    };
+
+    // Times a stage from construction to destruction.
+    class Scope
+    {
+    public:
+        Scope(Profiler &profiler, Stage stage) :
+            profiler_(profiler),
+            stage_(stage),
+            start_(Clock::now())
+        {
+        }
+
+        ~Scope()
+        {
+            profiler_.record(stage_, start_);
+        }
+
+    private:
+        Profiler &profiler_;
+        Stage stage_;
+        Clock::time_point start_;
+    };
+
+    Profiler();
+
+    void beginFrame();
+
+    void endFrame();
+
+    // Drops the current frame, for loop iterations that showed nothing new
+    // and would only skew the percentiles.
+    void discardFrame();
+
+    // Adds to the stage's time in the current frame; a stage may run more
+    // than once per frame.
+    void record(Stage stage, double ms);
+
+    // Records the time since start, and a trace zone for it when tracing
+    // is compiled in.
+    void record(Stage stage, Clock::time_point start);
+
+    void recordCounters(Stage stage, const PerfCounters::Sample &sample, long long units);
+
+    // The stage's allocations in one frame.
+    void recordAllocations(Stage stage, const AllocTracker::Counts &counts);
+
+    Summary getSummary(Stage stage) const;
+
+    const Counters &getCounters(Stage stage) const;
+
+    const Allocations &getAllocations(Stage stage) const;
+
+    // One row per frame in the window, an empty cell where a stage did not
+    // run.
+    void writeCsv(const std::string &path) const;
+
+    // Window percentiles and whole run histograms for every stage, and
+    // counters and allocations for those that have any.
+    void writeJson(const std::string &path) const;
+
+    // IPC and events per unit of work of every stage with counters, as a
+    // table.
+    void writeCounters(std::ostream &out) const;
+
+    // Allocations and bytes per frame of every stage with recorded
+    // allocations, as a table.
+    void writeAllocations(std::ostream &out) const;
+
+    static const char *getStageName(Stage stage);
+
+    // What counters are divided by: triangles in for the geometry stages,
+    // pixels for clear and rasterize, frames otherwise.
+    static const char *getStageUnit(Stage stage);
+
+private:
+    constexpr static int WINDOW = 1024;
+    // Bucket i holds times in [2^i, 2^(i+1)) microseconds, the first one
+    // everything below 2 us and the last one everything from about 8 s.
+    constexpr static int BUCKET_COUNT = 24;
+
+    using Row = std::array<double, STAGE_COUNT>;
+
+    std::vector<Row> rows_;
+    std::vector<long long> row_frames_;
+    long long frame_;
+    Clock::time_point frame_start_;
+
+    std::array<std::array<long long, BUCKET_COUNT>, STAGE_COUNT> histograms_;
+    std::array<Counters, STAGE_COUNT> counters_;
+    std::array<Allocations, STAGE_COUNT> allocations_;
+
+    mutable std::vector<double> scratch_;
+};
@@ -0,0 +1,698 @@
+#include "renderer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <limits>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "model.hpp"
+#include "rendertarget.hpp"
+#include "scene.hpp"
+#include "threadpool.hpp"
+#include "trace.hpp"
+
+#define LOG_MODULE_NAME ("Renderer")
+#include "log.hpp"
+
+namespace
+{
+    // Time stamp counter where there is one, steady clock ticks elsewhere.
+    // The tile time view only shows ratios, so the unit does not matter.
+    uint64_t readCycles()
+    {
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+    }
+}
+
+Renderer::Renderer(const std::shared_ptr<ThreadPool> &thread_pool) :
+    thread_pool_(thread_pool),
+    occlusion_(false),
+    occlusion_debug_(false),
+    debug_view_(DebugView::NONE),
+    frame_(0),
+    last_width_(0),
+    last_height_(0),
+    last_debug_(false),
+    history_(HISTORY),
+    stats_()
+{
+    for (History &history : history_)
+        history.frame = -1;
+    LOG_INFO << "Instance created." << std::endl;
+}
+
+void Renderer::setOcclusion(bool occlusion)
+{
+    occlusion_ = occlusion;
+}
+
+bool Renderer::getOcclusion() const
+{
+    return occlusion_;
+}
+
+void Renderer::setOcclusionDebug(bool occlusion_debug)
+{
+    occlusion_debug_ = occlusion_debug;
+}
+
+bool Renderer::getOcclusionDebug() const
+{
+    return occlusion_debug_;
+}
+
+void Renderer::setDebugView(DebugView debug_view)
+{
+    debug_view_ = debug_view;
+}
+
+Renderer::DebugView Renderer::getDebugView() const
+{
+    return debug_view_;
+}
+
+const Renderer::Stats &Renderer::getStats() const
+{
+    return stats_;
+}
+
+const TileMask &Renderer::getDamage() const
+{
+    return damage_;
+}
+
+bool Renderer::parseDebugView(const std::string &name, DebugView &debug_view)
+{
+    for (DebugView v : { DebugView::NONE, DebugView::OVERDRAW, DebugView::DEPTH_FAIL, DebugView::TILE_TIME })
+    {
+        if (name == getDebugViewName(v))
+        {
+            debug_view = v;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *Renderer::getDebugViewName(DebugView debug_view)
+{
+    switch (debug_view)
+    {
+    case DebugView::NONE:
+        return "none";
+    case DebugView::OVERDRAW:
+        return "overdraw";
+    case DebugView::DEPTH_FAIL:
+        return "depthfail";
+    case DebugView::TILE_TIME:
+        return "tiletime";
+    default:
+        return "unknown";
+    }
+}
+
+glm::ivec4 Renderer::screenRect(
+    const Aabb &box,
+    const glm::dmat4 &view_projection,
+    int width,
+    int height)
+{
+    glm::dvec2 lo(std::numeric_limits<double>::max());
+    glm::dvec2 hi(std::numeric_limits<double>::lowest());
+    for (int i = 0; i < 8; i++)
+    {
+        const glm::dvec4 p = view_projection * glm::dvec4(
+            i & 1 ? box.hi.x : box.lo.x,
+            i & 2 ? box.hi.y : box.lo.y,
+            i & 4 ? box.hi.z : box.lo.z,
+            1.0);
+        // Crossing the near plane; no bound worth computing.
+        if (p.w < NEAR)
+            return glm::ivec4(0, 0, width, height);
+
+        // Same mapping as the viewport matrix, rows counted from the top.
+        const glm::dvec2 s(
+            p.x / p.w * width / 2.0 + (width - 1) / 2.0,
+            (height - 1) - (p.y / p.w * height / 2.0 + (height - 1) / 2.0));
+        lo = glm::min(lo, s);
+        hi = glm::max(hi, s);
+    }
+
+    // A couple of pixels of slack for rounding in the rasterizer.
+    return glm::ivec4(
+        (int)glm::floor(lo.x) - 2,
+        (int)glm::floor(lo.y) - 2,
+        (int)glm::ceil(hi.x) + 3,
+        (int)glm::ceil(hi.y) + 3);
+}
+
+void Renderer::trackDamage(
+    const Scene &scene,
+    const glm::dmat4 &view,
+    const glm::dmat4 &projection,
+    int width,
+    int height)
+{
+    damage_.reset(width, height);
+
+    // Debug overlays and views cover everything, as does a new size.
+    const bool debug = (occlusion_ && occlusion_debug_) || debug_view_ != DebugView::NONE;
+    if (width != last_width_ || height != last_height_ || debug || last_debug_)
+        damage_.setAll();
+    last_width_ = width;
+    last_height_ = height;
+    last_debug_ = debug;
+
+    if (footprints_.size() < (size_t)scene.getObjectCount())
+    {
+        Footprint none;
+        none.frame = -1;
+        footprints_.resize(scene.getObjectCount(), none);
+    }
+
+    const glm::dmat4 view_projection = projection * view;
+    for (int id : visible_objects_)
+    {
+        const Scene::Object &object = scene.getObject(id);
+        const glm::dmat4 model_view = view * object.transform;
+        const glm::ivec4 rect = screenRect(scene.getBounds(id), view_projection, width, height);
+
+        Footprint &footprint = footprints_[id];
+        const bool was_visible = footprint.frame == frame_ - 1;
+        if (!was_visible ||
+            !(footprint.model_view == model_view) ||
+            footprint.lod_level != object.lod_level)
+        {
+            damage_.setPixels(rect.x, rect.y, rect.z, rect.w);
+            if (was_visible)
+                damage_.setPixels(footprint.rect.x, footprint.rect.y, footprint.rect.z, footprint.rect.w);
+        }
+
+        footprint.model_view = model_view;
+        footprint.lod_level = object.lod_level;
+        footprint.frame = frame_;
+        footprint.rect = rect;
+    }
+
+    // Whatever disappeared leaves a hole to fill.
+    for (int id : last_visible_)
+    {
+        const Footprint &footprint = footprints_[id];
+        if (footprint.frame == frame_ - 1)
+            damage_.setPixels(footprint.rect.x, footprint.rect.y, footprint.rect.z, footprint.rect.w);
+    }
+    last_visible_ = visible_objects_;
+
+    History &history = history_[frame_ % HISTORY];
+    history.frame = frame_;
+    history.damage = damage_;
+}
+
+void Renderer::cullOccluded(
+    const Scene &scene,
+    const glm::dmat4 &view,
+    const glm::dmat4 &projection)
+{
+    // Nearest occluders first; they hide the most.
+    occluders_.clear();
+    for (int id : visible_objects_)
+    {
+        if (scene.getObject(id).occluder)
+        {
+            const glm::dvec4 c = view * glm::dvec4(scene.getBounds(id).center(), 1.0);
+            occluders_.emplace_back(-c.z, id);
+        }
+    }
+    const int occluder_count = std::min((int)occluders_.size(), (int)MAX_OCCLUDERS);
+    std::partial_sort(occluders_.begin(), occluders_.begin() + occluder_count, occluders_.end());
+
+    occlusion_culler_.begin(projection * view);
+    for (int i = 0; i < occluder_count; i++)
+    {
+        const Scene::Object &object = scene.getObject(occluders_[i].second);
+        occlusion_culler_.renderOccluder(
+            object.model->getLodChain().getLevel(0),
+            object.transform);
+    }
+
+    visible_objects_.erase(
+        std::remove_if(
+            visible_objects_.begin(),
+            visible_objects_.end(),
+            [&](int id)
+            {
+                for (int i = 0; i < occluder_count; i++)
+                    if (occluders_[i].second == id)
+                        return false;
+                return !occlusion_culler_.isVisible(scene.getBounds(id));
+            }),
+        visible_objects_.end());
+}
+
+template <PixelFormat FORMAT>
+void Renderer::rasterize(FramebufferView &framebuffer, const TileMask *scissor)
+{
+    constexpr int TILE = TileMask::TILE;
+
+    const int height = framebuffer.getHeight();
+    const bool heat = !heat_fragments_.empty();
+    long long fragments = 0;
+    long long written = 0;
+    for (const Mesh &mesh : clipped_)
+    {
+        TRACE_ZONE("rasterize meshlet");
+        const auto &vertices = mesh.getVertices();
+        const auto &indices = mesh.getIndices();
+        const auto &normals = mesh.getNormals();
+
+        const int triangle_count = indices.size() / 3;
+        for (int i = 0; i < triangle_count; i++)
+        {
+            const glm::dvec4 &a = vertices[indices[3 * i + 0]];
+            const glm::dvec4 &b = vertices[indices[3 * i + 1]];
+            const glm::dvec4 &c = vertices[indices[3 * i + 2]];
+
+            if (scissor)
+            {
+                const int x0 = (int)glm::min(a.x, glm::min(b.x, c.x));
+                const int x1 = (int)glm::max(a.x, glm::max(b.x, c.x)) + 1;
+                const int y0 = (int)glm::min(a.y, glm::min(b.y, c.y));
+                const int y1 = (int)glm::max(a.y, glm::max(b.y, c.y)) + 1;
+                if (!scissor->testPixels(x0, height - y1, x1, height - y0))
+                    continue;
+            }
+
+            const double l = glm::mix(
+                0.2,
+                1.0,
+                glm::max(0.0, glm::dot(normals[i], glm::dvec3(0.0, 0.0, 1.0))));
+            const uint32_t color = packPixel<FORMAT>(glm::dvec3(l));
+
+            spans_.clear();
+            triangleSpans(
+                a.x, a.y, a.z,
+                b.x, b.y, b.z,
+                c.x, c.y, c.z,
+                spans_);
+            for (const Span &span : spans_)
+            {
+                // Raster y runs up, framebuffer rows run down.
+                const int y = height - 1 - span.y;
+                if (!scissor)
+                {
+                    if (heat)
+                        countHeat(framebuffer, y, span.x, span.count, span.z, span.dz);
+                    fragments += span.count;
+                    written += framebuffer.depthTestSpan(y, span.x, span.count, span.z, span.dz, color);
+                    continue;
+                }
+
+                const int end = span.x + span.count;
+                for (int tx = span.x / TILE; tx * TILE < end; tx++)
+                {
+                    if (!scissor->test(tx, y / TILE))
+                        continue;
+                    const int x0 = std::max(span.x, tx * TILE);
+                    const int x1 = std::min(end, (tx + 1) * TILE);
+                    const double z = span.z + (x0 - span.x) * span.dz;
+                    if (heat)
+                        countHeat(framebuffer, y, x0, x1 - x0, z, span.dz);
+                    fragments += x1 - x0;
+                    written += framebuffer.depthTestSpan(y, x0, x1 - x0, z, span.dz, color);
+                }
+            }
+        }
+    }
+    stats_.pipeline.fragments += fragments;
+    stats_.pipeline.depth_passed += written;
+    stats_.pipeline.depth_failed += fragments - written;
+    stats_.pipeline.written_pixels += written;
+}
+
+void Renderer::rasterizeFormat(FramebufferView &framebuffer, const TileMask *scissor)
+{
+    switch (framebuffer.getFormat())
+    {
+    case PixelFormat::RGBA8888:
+        rasterize<PixelFormat::RGBA8888>(framebuffer, scissor);
+        break;
+    case PixelFormat::ARGB8888:
+        rasterize<PixelFormat::ARGB8888>(framebuffer, scissor);
+        break;
+    case PixelFormat::ABGR8888:
+        rasterize<PixelFormat::ABGR8888>(framebuffer, scissor);
+        break;
+    case PixelFormat::BGRA8888:
+        rasterize<PixelFormat::BGRA8888>(framebuffer, scissor);
+        break;
+    }
+}
+
+void Renderer::countHeat(FramebufferView &framebuffer, int y, int x, int count, double z, double dz)
+{
+    const double *depth = framebuffer.getDepthRow(y) + x;
+    const size_t offset = (size_t)y * framebuffer.getWidth() + x;
+    uint32_t *fragments = heat_fragments_.data() + offset;
+    uint32_t *failures = heat_failures_.data() + offset;
+    for (int i = 0; i < count; i++)
+    {
+        fragments[i]++;
+        // Same test as depthTestSpan(), which passes on less or equal.
+        if (z > depth[i])
+            failures[i]++;
+        z += dz;
+    }
+}
+
+void Renderer::drawHeatmap(FramebufferView &framebuffer)
+{
+    constexpr int TILE = TileMask::TILE;
+
+    // Black through blue, green, yellow and red to white.
+    static const glm::dvec3 STOPS[] =
+    {
+        glm::dvec3(0.0, 0.0, 0.0),
+        glm::dvec3(0.0, 0.0, 1.0),
+        glm::dvec3(0.0, 1.0, 0.0),
+        glm::dvec3(1.0, 1.0, 0.0),
+        glm::dvec3(1.0, 0.0, 0.0),
+        glm::dvec3(1.0, 1.0, 1.0)
+    };
+    constexpr int STOP_COUNT = sizeof(STOPS) / sizeof(STOPS[0]);
+
+    std::array<uint32_t, 256> palette;
+    for (int i = 0; i < (int)palette.size(); i++)
+    {
+        const double t = (double)i / (palette.size() - 1) * (STOP_COUNT - 1);
+        const int stop = std::min((int)t, STOP_COUNT - 2);
+        palette[i] = packPixel(
+            framebuffer.getFormat(),
+            glm::mix(STOPS[stop], STOPS[stop + 1], t - stop));
+    }
+
+    const int width = framebuffer.getWidth();
+    const int height = framebuffer.getHeight();
+    if (debug_view_ == DebugView::TILE_TIME)
+    {
+        const int tiles_x = (width + TILE - 1) / TILE;
+        const uint64_t slowest = std::max<uint64_t>(
+            1,
+            *std::max_element(tile_cycles_.begin(), tile_cycles_.end()));
+        for (int i = 0; i < (int)tile_cycles_.size(); i++)
+        {
+            const int x = i % tiles_x * TILE;
+            const int y = i / tiles_x * TILE;
+            framebuffer.fillTile(
+                x,
+                y,
+                std::min(TILE, width - x),
+                std::min(TILE, height - y),
+                palette[tile_cycles_[i] * (palette.size() - 1) / slowest]);
+        }
+        return;
+    }
+
+    const std::vector<uint32_t> &counts =
+        debug_view_ == DebugView::OVERDRAW ? heat_fragments_ : heat_failures_;
+    for (int y = 0; y < height; y++)
+    {
+        const uint32_t *row = counts.data() + (size_t)y * width;
+        uint32_t *colors = framebuffer.getColorRow(y);
+        for (int x = 0; x < width; x++)
+        {
+            const uint32_t count = std::min<uint32_t>(row[x], HEAT_SCALE);
+            colors[x] = palette[count * (palette.size() - 1) / HEAT_SCALE];
+        }
+    }
+}
+
+void Renderer::render(
+    Scene &scene,
+    const glm::dmat4 &view,
+    RenderTarget &target)
+{
+    constexpr double RAD = glm::pi<double>() / 180.0;
+
+    const int width = target.getWidth();
+    const int height = target.getHeight();
+
+    const glm::dmat4 viewport(
+        width / 2.0, 0.0, 0.0, 0.0,
+        0.0, height / 2.0, 0.0, 0.0,
+        0.0, 0.0, 10.0, 0.0,
+        (width - 1) / 2.0, (height - 1) / 2.0, 0.0, 1.0);
+    const glm::dmat4 projection =
+        glm::perspective(FIELD_OF_VIEW * RAD, (double)width / (double)height, NEAR, FAR);
+    const double focal_length = projection[1][1] * height / 2.0;
+
+    using Clock = std::chrono::steady_clock;
+    auto milliseconds = [](Clock::time_point a, Clock::time_point b)
+    {
+        return std::chrono::duration<double, std::milli>(b - a).count();
+    };
+
+    // The pool registers its workers; this covers whichever thread renders.
+    PerfCounters::registerThread();
+    PerfCounters::Sample cull_sample;
+    PerfCounters::Sample transform_sample;
+    PerfCounters::Sample clip_sample;
+    PerfCounters::Sample clear_sample;
+    PerfCounters::Sample rasterize_sample;
+    PerfCounters::Sample rasterize_end_sample;
+    AllocTracker::Counts cull_allocations;
+    AllocTracker::Counts transform_allocations;
+    AllocTracker::Counts clip_allocations;
+    AllocTracker::Counts clear_allocations;
+    AllocTracker::Counts rasterize_allocations;
+    AllocTracker::Counts rasterize_end_allocations;
+
+    stats_ = Stats();
+    const Clock::time_point cull_start = Clock::now();
+    PerfCounters::read(cull_sample);
+    AllocTracker::setTag("cull");
+    AllocTracker::read(cull_allocations);
+
+    scene.update(thread_pool_.get());
+    visible_objects_.clear();
+    scene.cull(view, projection, visible_objects_);
+
+    if (occlusion_)
+    {
+        cullOccluded(scene, view, projection);
+        stats_.occlusion = occlusion_culler_.getStats();
+    }
+    stats_.visible_objects = visible_objects_.size();
+
+    for (int id : visible_objects_)
+    {
+        const Scene::Object &object = scene.getObject(id);
+        scene.setLodLevel(
+            id,
+            object.model->getLodChain().select(
+                view * object.transform, focal_length, object.lod_level));
+    }
+
+    frame_++;
+    trackDamage(scene, view, projection, width, height);
+
+    // Tiles to redraw: everything that changed since the frame the target
+    // holds, as long as that is recent enough to be in the history.
+    const long long content_frame = target.getContentFrame();
+    bool partial = target.retainsContents() &&
+        content_frame >= 0 &&
+        frame_ - content_frame <= HISTORY;
+    redraw_ = damage_;
+    for (long long f = content_frame + 1; partial && f < frame_; f++)
+    {
+        const History &history = history_[f % HISTORY];
+        if (history.frame != f)
+            partial = false;
+        else
+            redraw_ |= history.damage;
+    }
+    if (!partial)
+        redraw_.setAll();
+    stats_.redrawn_tiles = redraw_.getSetCount();
+    stats_.damaged_tiles = damage_.getSetCount();
+    stats_.tile_count = redraw_.getTileCount();
+
+    jobs_.clear();
+    for (int id : visible_objects_)
+    {
+        // Objects entirely outside the redrawn tiles are left as they are.
+        const glm::ivec4 &rect = footprints_[id].rect;
+        if (partial && !redraw_.testPixels(rect.x, rect.y, rect.z, rect.w))
+            continue;
+
+        const Scene::Object &object = scene.getObject(id);
+        const glm::dmat4 model_view = view * object.transform;
+        const int lod_level = object.lod_level;
+
+        const auto &meshlets = object.model->getMeshlets(lod_level);
+        for (int i = 0; i < (int)meshlets.size(); i++)
+        {
+            if (meshlets[i].isVisible(model_view, projection))
+            {
+                jobs_.push_back(MeshletJob{ id, i });
+                stats_.rendered_triangles += meshlets[i].getMesh().getIndices().size() / 3;
+            }
+        }
+    }
+
+    // Transform and clip run as separate passes so the profiler can tell
+    // them apart; the extra join is cheap next to either.
+    const Clock::time_point transform_start = Clock::now();
+    PerfCounters::read(transform_sample);
+    AllocTracker::setTag("transform");
+    AllocTracker::read(transform_allocations);
+    // Never shrinks, so every mesh keeps its buffers from frame to frame;
+    // meshes past the jobs are left empty.
+    if (clipped_.size() < jobs_.size())
+        clipped_.resize(jobs_.size());
+    for (size_t i = jobs_.size(); i < clipped_.size(); i++)
+        clipped_[i].clear();
+    thread_pool_->parallelFor(
+        jobs_.size(),
+        [this, &scene, &view](int i)
+        {
+            const Scene::Object &object = scene.getObject(jobs_[i].object);
+            clipped_[i] = object.model->getMeshlets(object.lod_level)[jobs_[i].meshlet].getMesh();
+            clipped_[i] *= view * object.transform;
+        });
+
+    const Clock::time_point clip_start = Clock::now();
+    PerfCounters::read(clip_sample);
+    AllocTracker::setTag("clip");
+    AllocTracker::read(clip_allocations);
+    clip_stats_.assign(jobs_.size(), PipelineStats());
+    thread_pool_->parallelFor(
+        jobs_.size(),
+        [this, &projection, &viewport](int i)
+        {
+            clipped_[i].clip(projection, viewport, &clip_stats_[i]);
+        });
+    for (const PipelineStats &clip_stats : clip_stats_)
+        stats_.pipeline += clip_stats;
+
+    const Clock::time_point raster_start = Clock::now();
+    PerfCounters::read(clear_sample);
+    AllocTracker::setTag("clear");
+    AllocTracker::read(clear_allocations);
+    FramebufferView framebuffer = target.lock();
+    const uint32_t background = packPixel(framebuffer.getFormat(), glm::dvec3(0.0));
+    if (partial)
+    {
+        rects_.clear();
+        redraw_.getRects(rects_);
+        for (const TileMask::Rect &rect : rects_)
+        {
+            framebuffer.clearTile(rect.x, rect.y, rect.width, rect.height, background, std::numeric_limits<double>::max());
+            stats_.pipeline.written_pixels += (long long)rect.width * rect.height;
+            stats_.pipeline.cleared_pixels += (long long)rect.width * rect.height;
+        }
+    }
+    else
+    {
+        framebuffer.clear(background, std::numeric_limits<double>::max());
+        stats_.pipeline.written_pixels += (long long)width * height;
+        stats_.pipeline.cleared_pixels += (long long)width * height;
+    }
+
+    const Clock::time_point rasterize_start = Clock::now();
+    PerfCounters::read(rasterize_sample);
+    AllocTracker::setTag("rasterize");
+    AllocTracker::read(rasterize_allocations);
+    if (debug_view_ == DebugView::OVERDRAW || debug_view_ == DebugView::DEPTH_FAIL)
+    {
+        heat_fragments_.assign((size_t)width * height, 0);
+        heat_failures_.assign((size_t)width * height, 0);
+    }
+    else
+    {
+        heat_fragments_.clear();
+        heat_failures_.clear();
+    }
+
+    if (debug_view_ == DebugView::TILE_TIME)
+    {
+        // One tile at a time, the way a tiled rasterizer walks the screen,
+        // so each tile's cost can be read off on its own. Debug views
+        // always redraw in full, so there is no scissor to honour.
+        constexpr int TILE = TileMask::TILE;
+        const int tiles_x = (width + TILE - 1) / TILE;
+        const int tiles_y = (height + TILE - 1) / TILE;
+        tile_cycles_.assign((size_t)tiles_x * tiles_y, 0);
+        for (int ty = 0; ty < tiles_y; ty++)
+        {
+            for (int tx = 0; tx < tiles_x; tx++)
+            {
+                tile_scissor_.reset(width, height);
+                tile_scissor_.setPixels(tx * TILE, ty * TILE, (tx + 1) * TILE, (ty + 1) * TILE);
+                const uint64_t start = readCycles();
+                rasterizeFormat(framebuffer, &tile_scissor_);
+                tile_cycles_[(size_t)ty * tiles_x + tx] = readCycles() - start;
+            }
+        }
+    }
+    else
+    {
+        rasterizeFormat(framebuffer, partial ? &redraw_ : nullptr);
+    }
+
+    if (debug_view_ != DebugView::NONE)
+    {
+        drawHeatmap(framebuffer);
+        stats_.pipeline.written_pixels += (long long)width * height;
+    }
+
+    if (occlusion_ && occlusion_debug_)
+    {
+        occlusion_culler_.drawDebug(framebuffer);
+        stats_.pipeline.written_pixels += (long long)width * height;
+    }
+
+    const Clock::time_point rasterize_end = Clock::now();
+    PerfCounters::read(rasterize_end_sample);
+    AllocTracker::read(rasterize_end_allocations);
+    AllocTracker::setTag(nullptr);
+    target.unlock();
+    target.setContentFrame(frame_);
+    const Clock::time_point raster_end = Clock::now();
+
+    stats_.cull_ms = milliseconds(cull_start, transform_start);
+    stats_.transform_ms = milliseconds(transform_start, clip_start);
+    stats_.clip_ms = milliseconds(clip_start, raster_start);
+    stats_.clear_ms = milliseconds(raster_start, rasterize_start);
+    stats_.rasterize_ms = milliseconds(rasterize_start, rasterize_end);
+    stats_.raster_ms = milliseconds(raster_start, raster_end);
+    stats_.cull_counters = transform_sample - cull_sample;
+    stats_.transform_counters = clip_sample - transform_sample;
+    stats_.clip_counters = clear_sample - clip_sample;
+    stats_.clear_counters = rasterize_sample - clear_sample;
+    stats_.rasterize_counters = rasterize_end_sample - rasterize_sample;
+    stats_.cull_allocations = transform_allocations - cull_allocations;
+    stats_.transform_allocations = clip_allocations - transform_allocations;
+    stats_.clip_allocations = clear_allocations - clip_allocations;
+    stats_.clear_allocations = rasterize_allocations - clear_allocations;
+    stats_.rasterize_allocations = rasterize_end_allocations - rasterize_allocations;
+
+    TRACE_COMPLETE("cull", cull_start, transform_start);
+    TRACE_COMPLETE("transform", transform_start, clip_start);
+    TRACE_COMPLETE("clip", clip_start, raster_start);
+    TRACE_COMPLETE("clear", raster_start, rasterize_start);
+    TRACE_COMPLETE("rasterize", rasterize_start, rasterize_end);
+    TRACE_COUNTER("triangles", stats_.rendered_triangles);
+    TRACE_COUNTER("pixels", stats_.pipeline.written_pixels);
+}
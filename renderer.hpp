@@ -0,0 +1,214 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "alloctracker.hpp"
+#include "framebuffer.hpp"
+#include "mesh.hpp"
+#include "bvh.hpp"
+#include "occlusionculler.hpp"
+#include "perfcounters.hpp"
+#include "pipelinestats.hpp"
+#include "tilemask.hpp"
+#include "triangle.hpp"
+
+class RenderTarget;
+class Scene;
+class ThreadPool;
+
+// Renders a Scene into any RenderTarget: BVH, occlusion and meshlet culling,
+// LOD selection, transform and clip on the thread pool, then rasterization.
+// Knows nothing about windows, so it runs headless as well as under SDL.
+//
+// Tracks the screen footprint of every visible object. Tiles covered by an
+// object that moved, changed LOD, appeared or disappeared make up the damage
+// of a frame. Targets that keep their contents only get the damage since
+// the frame they hold cleared and redrawn; everything else is redrawn in
+// full.
+class Renderer
+{
+public:
+    // Heatmaps drawn in place of the shaded image, all redrawn in full:
+    // fragments per pixel, failed depth tests per pixel, and the time spent
+    // rasterizing each tile relative to the slowest tile of the frame.
+    enum class DebugView
+    {
+        NONE,
+        OVERDRAW,
+        DEPTH_FAIL,
+        TILE_TIME
+    };
+
+    struct Stats
+    {
+        int visible_objects;
+        int rendered_triangles;
+        PipelineStats pipeline;
+        // Stage times. cull_ms covers everything before the meshlets are
+        // transformed: scene update, culling, LOD selection and damage.
+        double cull_ms;
+        double transform_ms;
+        double clip_ms;
+        double clear_ms;
+        double rasterize_ms;
+        // Clear and rasterization only; the part that scales with the
+        // resolution.
+        double raster_ms;
+        // Hardware counters per stage, summed over the rendering thread
+        // and the pool; zero unless PerfCounters::open() succeeded.
+        PerfCounters::Sample cull_counters;
+        PerfCounters::Sample transform_counters;
+        PerfCounters::Sample clip_counters;
+        PerfCounters::Sample clear_counters;
+        PerfCounters::Sample rasterize_counters;
+        // Heap allocations per stage, by any thread; zero unless built
+        // with SWR_ALLOC_TRACKING.
+        AllocTracker::Counts cull_allocations;
+        AllocTracker::Counts transform_allocations;
+        AllocTracker::Counts clip_allocations;
+        AllocTracker::Counts clear_allocations;
+        AllocTracker::Counts rasterize_allocations;
+        int redrawn_tiles;
+        int damaged_tiles;
+        int tile_count;
+        OcclusionCuller::Stats occlusion;
+    };
+
+    Renderer(const std::shared_ptr<ThreadPool> &thread_pool);
+
+    void setOcclusion(bool occlusion);
+
+    bool getOcclusion() const;
+
+    void setOcclusionDebug(bool occlusion_debug);
+
+    bool getOcclusionDebug() const;
+
+    void setDebugView(DebugView debug_view);
+
+    DebugView getDebugView() const;
+
+    void render(
+        Scene &scene,
+        const glm::dmat4 &view,
+        RenderTarget &target);
+
+    const Stats &getStats() const;
+
+    // Tiles that differ between the last frame and the one before it.
+    const TileMask &getDamage() const;
+
+    static bool parseDebugView(const std::string &name, DebugView &debug_view);
+
+    static const char *getDebugViewName(DebugView debug_view);
+
+private:
+    void cullOccluded(
+        const Scene &scene,
+        const glm::dmat4 &view,
+        const glm::dmat4 &projection);
+
+    // Marks the tiles that changed since the previous frame in damage_.
+    void trackDamage(
+        const Scene &scene,
+        const glm::dmat4 &view,
+        const glm::dmat4 &projection,
+        int width,
+        int height);
+
+    // Pixel rectangle [x0, x1) x [y0, y1) covering the box on screen.
+    static glm::ivec4 screenRect(
+        const Aabb &box,
+        const glm::dmat4 &view_projection,
+        int width,
+        int height);
+
+    // Draws the clipped meshes. Without a scissor the whole framebuffer is
+    // drawn, with one only the tiles set in it. Instantiated once per pixel
+    // format, so shading packs straight into the target's layout.
+    template <PixelFormat FORMAT>
+    void rasterize(FramebufferView &framebuffer, const TileMask *scissor);
+
+    // Picks the instantiation for the framebuffer's format.
+    void rasterizeFormat(FramebufferView &framebuffer, const TileMask *scissor);
+
+    // Adds a span's fragments and failed depth tests to the heat buffers.
+    // Runs before the span's depth test, against the depth it will see.
+    void countHeat(FramebufferView &framebuffer, int y, int x, int count, double z, double dz);
+
+    // Color maps the heat buffers or tile times over the whole framebuffer.
+    void drawHeatmap(FramebufferView &framebuffer);
+
+private:
+    struct MeshletJob
+    {
+        int object;
+        int meshlet;
+    };
+
+    struct Footprint
+    {
+        glm::dmat4 model_view;
+        int lod_level;
+        long long frame;
+        glm::ivec4 rect;
+    };
+
+    struct History
+    {
+        long long frame;
+        TileMask damage;
+    };
+
+    std::shared_ptr<ThreadPool> thread_pool_;
+
+    bool occlusion_;
+    bool occlusion_debug_;
+    OcclusionCuller occlusion_culler_;
+
+    DebugView debug_view_;
+    // Per pixel counts of the overdraw and depth fail views, and per tile
+    // cycles of the tile time view.
+    std::vector<uint32_t> heat_fragments_;
+    std::vector<uint32_t> heat_failures_;
+    std::vector<uint64_t> tile_cycles_;
+    TileMask tile_scissor_;
+
+    std::vector<int> visible_objects_;
+    std::vector<std::pair<double, int>> occluders_;
+    std::vector<MeshletJob> jobs_;
+    std::vector<Mesh> clipped_;
+    // One per clip job, summed into stats_.pipeline after the pass.
+    std::vector<PipelineStats> clip_stats_;
+    std::vector<Span> spans_;
+
+    long long frame_;
+    int last_width_;
+    int last_height_;
+    bool last_debug_;
+    std::vector<Footprint> footprints_;
+    std::vector<int> last_visible_;
+    TileMask damage_;
+    TileMask redraw_;
+    std::vector<TileMask::Rect> rects_;
+    std::vector<History> history_;
+
+    Stats stats_;
+
+    constexpr static double FIELD_OF_VIEW = 27.0;
+    constexpr static double NEAR = 0.1;
+    constexpr static double FAR = 400.0;
+    constexpr static int MAX_OCCLUDERS = 8;
+    // Frames of damage kept, i.e. how old a target's contents may be and
+    // still be updated in part. Covers triple buffering.
+    constexpr static int HISTORY = 4;
+    // Count shown at full heat by the per pixel views; a fixed scale keeps
+    // frames comparable.
+    constexpr static int HEAT_SCALE = 8;
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "framebuffer.hpp"
+
+// A place frames end up in: a window texture, plain memory, ... Only lock()
+// and unlock() are virtual and they run once per frame; all pixel work goes
+// through the FramebufferView in between.
+class RenderTarget
+{
+public:
+    virtual ~RenderTarget()
+    {
+    }
+
+    virtual int getWidth() const = 0;
+
+    virtual int getHeight() const = 0;
+
+    virtual FramebufferView lock() = 0;
+
+    virtual void unlock() = 0;
+
+    // Whether pixels rendered into the target are still there at the next
+    // lock(). Locked texture memory, for one, is write only.
+    virtual bool retainsContents() const = 0;
+
+    // Number of the Renderer frame whose pixels the target holds, or -1 when
+    // unknown. Lets the Renderer redraw only what changed since then.
+    long long getContentFrame() const
+    {
+        return content_frame_;
+    }
+
+    void setContentFrame(long long frame)
+    {
+        content_frame_ = frame;
+    }
+
+protected:
+    RenderTarget() :
+        content_frame_(-1)
+    {
+    }
+
+    long long content_frame_;
+};
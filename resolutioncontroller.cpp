@@ -0,0 +1,82 @@
+#include "resolutioncontroller.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#define LOG_MODULE_NAME ("ResolutionController")
+#include "log.hpp"
+
+constexpr double ResolutionController::MAX_CHANGE;
+
+ResolutionController::ResolutionController(double budget_ms, double min_scale, double max_scale) :
+    budget_ms_(budget_ms),
+    min_scale_(min_scale),
+    max_scale_(max_scale),
+    scale_(max_scale),
+    average_ms_(0.0),
+    frames_since_change_(0)
+{
+    if (min_scale_ <= 0.0 || max_scale_ < min_scale_)
+    {
+        LOG_ERROR << "Failure in ResolutionController, bad scale range. (" << min_scale_ << " " << max_scale_ << ")" << std::endl;
+        throw std::exception();
+    }
+    LOG_INFO << "Instance created." << std::endl;
+}
+
+bool ResolutionController::isEnabled() const
+{
+    return budget_ms_ > 0.0;
+}
+
+void ResolutionController::update(double raster_ms)
+{
+    if (!isEnabled())
+        return;
+
+    average_ms_ = frames_since_change_ == 0 ?
+        raster_ms :
+        glm::mix(average_ms_, raster_ms, SMOOTHING);
+    frames_since_change_++;
+
+    if (frames_since_change_ < SETTLE_FRAMES || average_ms_ <= 0.0)
+        return;
+    if (average_ms_ <= budget_ms_ && average_ms_ >= RAISE_BELOW * budget_ms_)
+        return;
+
+    const double factor = std::max(
+        1.0 / MAX_CHANGE,
+        std::min(MAX_CHANGE, std::sqrt(TARGET * budget_ms_ / average_ms_)));
+    const double scale = std::max(
+        min_scale_,
+        std::min(max_scale_, std::round(scale_ * factor / SCALE_STEP) * SCALE_STEP));
+    if (scale == scale_)
+        return;
+
+    scale_ = scale;
+    frames_since_change_ = 0;
+}
+
+double ResolutionController::getScale() const
+{
+    return scale_;
+}
+
+double ResolutionController::getMaxScale() const
+{
+    return max_scale_;
+}
+
+glm::ivec2 ResolutionController::getSize(int window_width, int window_height) const
+{
+    return glm::ivec2(
+        std::max(1, (int)std::lround(window_width * scale_)),
+        std::max(1, (int)std::lround(window_height * scale_)));
+}
+
+glm::ivec2 ResolutionController::getMaxSize(int window_width, int window_height) const
+{
+    return glm::ivec2(
+        std::max(1, (int)std::lround(window_width * max_scale_)),
+        std::max(1, (int)std::lround(window_height * max_scale_)));
+}
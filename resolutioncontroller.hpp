@@ -0,0 +1,49 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// Picks the internal render resolution, as a scale of the window size, so
+// that rasterization stays within a frame time budget. Raster time grows
+// with the pixel count, i.e. with the square of the scale, which gives the
+// size of each correction. Changes are quantized and spaced out so the
+// target does not get resized every frame.
+class ResolutionController
+{
+public:
+    // A budget of zero disables the controller and keeps max_scale.
+    ResolutionController(double budget_ms, double min_scale, double max_scale);
+
+    bool isEnabled() const;
+
+    // Feeds the raster time of the frame just finished.
+    void update(double raster_ms);
+
+    double getScale() const;
+
+    double getMaxScale() const;
+
+    // Internal resolution for a window of the given size.
+    glm::ivec2 getSize(int window_width, int window_height) const;
+
+    // Largest internal resolution the controller will ever ask for, which is
+    // what render targets have to be allocated for.
+    glm::ivec2 getMaxSize(int window_width, int window_height) const;
+
+private:
+    double budget_ms_;
+    double min_scale_;
+    double max_scale_;
+    double scale_;
+    double average_ms_;
+    int frames_since_change_;
+
+    // Weight of the newest frame in the running average.
+    constexpr static double SMOOTHING = 0.1;
+    // Frames to wait after a change before judging the new scale.
+    constexpr static int SETTLE_FRAMES = 8;
+    // Aim a little below the budget; raise only with room to spare.
+    constexpr static double TARGET = 0.9;
+    constexpr static double RAISE_BELOW = 0.75;
+    constexpr static double SCALE_STEP = 1.0 / 32.0;
+    constexpr static double MAX_CHANGE = 1.25;
+};
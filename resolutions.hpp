@@ -0,0 +1,22 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+// Window sizes, smallest first. SDLWindow opens the largest one that fits
+// the desktop; swr-bench renders frames at each of them.
+inline const std::vector<std::pair<int, int>> &getDefaultResolutionList()
+{
+    static const std::vector<std::pair<int, int>> default_resolution_list =
+    {
+        std::pair<int, int>(320, 240),
+        std::pair<int, int>(640, 480),
+        std::pair<int, int>(800, 600),
+        std::pair<int, int>(1024, 768),
+        std::pair<int, int>(1280, 960),
+        std::pair<int, int>(1440, 1080),
+        std::pair<int, int>(1600, 1200),
+        std::pair<int, int>(2048, 1536)
+    };
+    return default_resolution_list;
+}
@@ -0,0 +1,105 @@
+#include "scene.hpp"
+
+#include "model.hpp"
+
+#define LOG_MODULE_NAME ("Scene")
+#include "log.hpp"
+
+Scene::Scene() :
+    rebuild_(false),
+    version_(0)
+{
+}
+
+int Scene::addObject(
+    const std::shared_ptr<const Model> &model,
+    const glm::dmat4 &transform,
+    bool occluder)
+{
+    objects_.push_back(Object{ model, transform, 0, occluder });
+    bounds_.push_back(worldBounds(objects_.back()));
+    is_moved_.push_back(false);
+    rebuild_ = true;
+    version_++;
+    return objects_.size() - 1;
+}
+
+void Scene::setTransform(int id, const glm::dmat4 &transform)
+{
+    objects_[id].transform = transform;
+    bounds_[id] = worldBounds(objects_[id]);
+    if (!is_moved_[id])
+    {
+        is_moved_[id] = true;
+        moved_.push_back(id);
+    }
+    version_++;
+}
+
+void Scene::setLodLevel(int id, int lod_level)
+{
+    objects_[id].lod_level = lod_level;
+}
+
+const Scene::Object &Scene::getObject(int id) const
+{
+    return objects_[id];
+}
+
+const Aabb &Scene::getBounds(int id) const
+{
+    return bounds_[id];
+}
+
+int Scene::getObjectCount() const
+{
+    return objects_.size();
+}
+
+unsigned int Scene::getVersion() const
+{
+    return version_;
+}
+
+const Bvh &Scene::getBvh() const
+{
+    return bvh_;
+}
+
+Aabb Scene::worldBounds(const Object &object) const
+{
+    // Box around the transformed bounding sphere of the model.
+    const LodChain &lod_chain = object.model->getLodChain();
+    const glm::dvec3 center(object.transform * glm::dvec4(lod_chain.getCenter(), 1.0));
+    const glm::dmat3 m(object.transform);
+    const double scale = glm::max(
+        glm::length(m[0]),
+        glm::max(glm::length(m[1]), glm::length(m[2])));
+    const glm::dvec3 r(lod_chain.getRadius() * scale);
+    return Aabb(center - r, center + r);
+}
+
+void Scene::update(ThreadPool *thread_pool)
+{
+    if (rebuild_)
+    {
+        bvh_.build(bounds_, thread_pool);
+        rebuild_ = false;
+    }
+    else if (!moved_.empty())
+    {
+        bvh_.refit(moved_, bounds_);
+    }
+
+    for (int id : moved_)
+        is_moved_[id] = false;
+    moved_.clear();
+}
+
+void Scene::cull(
+    const glm::dmat4 &view,
+    const glm::dmat4 &projection,
+    std::vector<int> &visible) const
+{
+    bvh_.cull(Frustum(projection * view), visible);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "bvh.hpp"
+
+class Model;
+class ThreadPool;
+
+// Objects placed in the world, each an instance of a shared Model, with a
+// BVH over their world bounds for frustum culling.
+class Scene
+{
+public:
+    struct Object
+    {
+        std::shared_ptr<const Model> model;
+        glm::dmat4 transform;
+        int lod_level;
+        bool occluder;
+    };
+
+    Scene();
+
+    int addObject(
+        const std::shared_ptr<const Model> &model,
+        const glm::dmat4 &transform,
+        bool occluder = false);
+
+    void setTransform(int id, const glm::dmat4 &transform);
+
+    void setLodLevel(int id, int lod_level);
+
+    const Object &getObject(int id) const;
+
+    const Aabb &getBounds(int id) const;
+
+    int getObjectCount() const;
+
+    // Bumped by addObject and setTransform, i.e. whenever a frame rendered
+    // earlier no longer shows the current scene.
+    unsigned int getVersion() const;
+
+    // Brings the BVH up to date: a full build after objects were added,
+    // otherwise a refit of the objects that moved.
+    void update(ThreadPool *thread_pool = nullptr);
+
+    // Appends the objects whose bounds intersect the view frustum.
+    void cull(
+        const glm::dmat4 &view,
+        const glm::dmat4 &projection,
+        std::vector<int> &visible) const;
+
+    const Bvh &getBvh() const;
+
+private:
+    Aabb worldBounds(const Object &object) const;
+
+private:
+    std::vector<Object> objects_;
+    std::vector<Aabb> bounds_;
+    std::vector<int> moved_;
+    std::vector<bool> is_moved_;
+    bool rebuild_;
+    unsigned int version_;
+    Bvh bvh_;
+};
@@ -0,0 +1,96 @@
+#include "sdlframebuffer.hpp"
+
+#include <algorithm>
+
+#include "sdlrenderer.hpp"
+#include "sdltexture.hpp"
+
+#define LOG_MODULE_NAME ("SDLFramebuffer")
+#include "log.hpp"
+
+SDLFramebuffer::SDLFramebuffer(
+    const std::shared_ptr<SDLRenderer> &sdl_renderer,
+    int width,
+    int height) :
+    sdl_renderer_(sdl_renderer),
+    depth_stride_(0),
+    width_(0),
+    height_(0)
+{
+    setSize(width, height);
+    LOG_INFO << "Instance created." << std::endl;
+}
+
+const std::shared_ptr<SDLTexture> &SDLFramebuffer::getTexture() const
+{
+    return sdl_texture_;
+}
+
+void SDLFramebuffer::setSize(int width, int height)
+{
+    width_ = std::max(1, width);
+    height_ = std::max(1, height);
+
+    if (!sdl_texture_ ||
+        width_ > sdl_texture_->getWidth() ||
+        height_ > sdl_texture_->getHeight())
+    {
+        const int texture_width = std::max(
+            (width_ + BUCKET - 1) / BUCKET * BUCKET,
+            sdl_texture_ ? sdl_texture_->getWidth() : 0);
+        const int texture_height = std::max(
+            (height_ + BUCKET - 1) / BUCKET * BUCKET,
+            sdl_texture_ ? sdl_texture_->getHeight() : 0);
+        sdl_texture_.reset();
+        sdl_texture_ = std::make_shared<SDLTexture>(
+            sdl_renderer_,
+            SDL_TEXTUREACCESS_STREAMING,
+            texture_width,
+            texture_height);
+        depth_stride_ = texture_width;
+        depth_.resize((size_t)texture_width * texture_height);
+    }
+}
+
+SDL_Rect SDLFramebuffer::getRect() const
+{
+    SDL_Rect rect;
+    rect.x = 0;
+    rect.y = 0;
+    rect.w = width_;
+    rect.h = height_;
+    return rect;
+}
+
+int SDLFramebuffer::getWidth() const
+{
+    return width_;
+}
+
+int SDLFramebuffer::getHeight() const
+{
+    return height_;
+}
+
+FramebufferView SDLFramebuffer::lock()
+{
+    sdl_texture_->lock();
+    return FramebufferView(
+        sdl_texture_->getPixels(),
+        sdl_texture_->getPitch(),
+        depth_.data(),
+        depth_stride_,
+        width_,
+        height_,
+        sdl_renderer_->getPixelFormat());
+}
+
+void SDLFramebuffer::unlock()
+{
+    sdl_texture_->updateTexture();
+}
+
+bool SDLFramebuffer::retainsContents() const
+{
+    return false;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <memory>
+
+#include <SDL.h>
+
+#include "alignedbuffer.hpp"
+#include "rendertarget.hpp"
+
+class SDLRenderer;
+class SDLTexture;
+
+// Render target backed by a streaming SDLTexture for color and an aligned
+// heap buffer for depth. Frames use the top left width x height corner of
+// the texture. Both only grow, in buckets, so resizing the window back and
+// forth or changing the render scale rarely allocates anything.
+class SDLFramebuffer : public RenderTarget
+{
+public:
+    SDLFramebuffer(
+        const std::shared_ptr<SDLRenderer> &sdl_renderer,
+        int width,
+        int height);
+
+    const std::shared_ptr<SDLTexture> &getTexture() const;
+
+    // Sets the frame size, growing the texture and depth buffer if needed.
+    void setSize(int width, int height);
+
+    // The part of the texture holding the frame.
+    SDL_Rect getRect() const;
+
+    int getWidth() const override;
+
+    int getHeight() const override;
+
+    FramebufferView lock() override;
+
+    void unlock() override;
+
+    bool retainsContents() const override;
+
+private:
+    std::shared_ptr<SDLRenderer> sdl_renderer_;
+    std::shared_ptr<SDLTexture> sdl_texture_;
+    AlignedBuffer<double> depth_;
+    int depth_stride_;
+    int width_;
+    int height_;
+
+    constexpr static int BUCKET = 256;
+};
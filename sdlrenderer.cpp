@@ -4,27 +4,56 @@
 
 #include "sdltexture.hpp"
 #include "sdlwindow.hpp"
+#include "trace.hpp"
 
 #define LOG_MODULE_NAME ("SDLRenderer")
 #include "log.hpp"
 
 SDLRenderer::SDLRenderer(
-    const std::shared_ptr<SDLWindow> &sdl_window)
+    const std::shared_ptr<SDLWindow> &sdl_window,
+    bool vsync)
     :
-		sdl_renderer_(nullptr)
+		sdl_renderer_(nullptr),
+        texture_format_(SDL_PIXELFORMAT_RGBA8888),
+        pixel_format_(PixelFormat::RGBA8888)
 {
     LOG_INFO << "Instance created." << std::endl;
 
     sdl_renderer_ = SDL_CreateRenderer(
         sdl_window->get(),
         -1,
-        SDL_RENDERER_PRESENTVSYNC);
+        vsync ? SDL_RENDERER_PRESENTVSYNC : 0);
 
     if (!sdl_renderer_)
     {
         LOG_ERROR << "Failure in SDL_CreateRenderer. (" << SDL_GetError() << ")" << std::endl;
         throw std::exception();
     }
+
+    negotiateFormat();
+}
+
+void SDLRenderer::negotiateFormat()
+{
+    SDL_RendererInfo info;
+    if (SDL_GetRendererInfo(sdl_renderer_, &info))
+    {
+        LOG_WARNING << "Failure in SDL_GetRendererInfo, using RGBA8888. (" << SDL_GetError() << ")" << std::endl;
+        return;
+    }
+
+    // Drivers list their formats best first; the rest get converted on
+    // every upload.
+    for (Uint32 i = 0; i < info.num_texture_formats; i++)
+    {
+        if (toPixelFormat(info.texture_formats[i], pixel_format_))
+        {
+            texture_format_ = info.texture_formats[i];
+            break;
+        }
+    }
+
+    LOG_INFO << "Texture format (" << SDL_GetPixelFormatName(texture_format_) << ") on renderer (" << info.name << ")" << std::endl;
 }
 
 SDLRenderer::~SDLRenderer()
@@ -38,18 +67,57 @@ SDL_Renderer *SDLRenderer::get() const
     return sdl_renderer_;
 }
 
+Uint32 SDLRenderer::getTextureFormat() const
+{
+    return texture_format_;
+}
+
+PixelFormat SDLRenderer::getPixelFormat() const
+{
+    return pixel_format_;
+}
+
+bool SDLRenderer::toPixelFormat(Uint32 sdl_format, PixelFormat &format)
+{
+    switch (sdl_format)
+    {
+    case SDL_PIXELFORMAT_RGBA8888:
+    case SDL_PIXELFORMAT_RGBX8888:
+        format = PixelFormat::RGBA8888;
+        return true;
+    case SDL_PIXELFORMAT_ARGB8888:
+    case SDL_PIXELFORMAT_RGB888:
+        format = PixelFormat::ARGB8888;
+        return true;
+    case SDL_PIXELFORMAT_ABGR8888:
+    case SDL_PIXELFORMAT_BGR888:
+        format = PixelFormat::ABGR8888;
+        return true;
+    case SDL_PIXELFORMAT_BGRA8888:
+    case SDL_PIXELFORMAT_BGRX8888:
+        format = PixelFormat::BGRA8888;
+        return true;
+    default:
+        return false;
+    }
+}
+
 void SDLRenderer::renderCopy(
-    const std::shared_ptr<SDLTexture> &sdl_texture)
+    const std::shared_ptr<SDLTexture> &sdl_texture,
+    const SDL_Rect *source,
+    const SDL_Rect *destination)
 {
+    TRACE_ZONE("SDL_RenderCopy");
     SDL_RenderCopy(
         sdl_renderer_,
         sdl_texture->get(),
-        nullptr,
-        nullptr);
+        source,
+        destination);
 }
 
 void SDLRenderer::renderPresent()
 {
+    TRACE_ZONE("SDL_RenderPresent");
     SDL_RenderPresent(sdl_renderer_);
 }
 
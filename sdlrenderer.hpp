@@ -4,24 +4,49 @@
 
 #include <SDL.h>
 
+#include "framebuffer.hpp"
+
 class SDLWindow;
 class SDLTexture;
 
 class SDLRenderer
 {
 public:
+    // Without vsync, renderPresent() returns immediately and pacing is up
+    // to the caller.
     SDLRenderer(
-        const std::shared_ptr<SDLWindow> &sdl_window);
+        const std::shared_ptr<SDLWindow> &sdl_window,
+        bool vsync = true);
     ~SDLRenderer();
 
     SDL_Renderer *get() const;
 
+    // Texture format the backend takes without converting: the first packed
+    // 32 bit format in its SDL_RendererInfo list, RGBA8888 if there is none.
+    Uint32 getTextureFormat() const;
+
+    // Byte order of getTextureFormat(), for writing pixels into it.
+    PixelFormat getPixelFormat() const;
+
+    // The byte order of an SDL texture format, if it is one of ours. Formats
+    // with an unused X channel map to their alpha counterpart.
+    static bool toPixelFormat(Uint32 sdl_format, PixelFormat &format);
+
+    // Stretches the given part of the texture, or all of it, over the
+    // destination rectangle, or the whole window.
     void renderCopy(
-        const std::shared_ptr<SDLTexture> &sdl_texture);
+        const std::shared_ptr<SDLTexture> &sdl_texture,
+        const SDL_Rect *source = nullptr,
+        const SDL_Rect *destination = nullptr);
 
     void renderPresent();
 
+private:
+    void negotiateFormat();
+
 private:
     SDL_Renderer *sdl_renderer_;
+    Uint32 texture_format_;
+    PixelFormat pixel_format_;
 };
 
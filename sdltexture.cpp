@@ -1,6 +1,7 @@
 #include "sdltexture.hpp"
 
 #include "sdlrenderer.hpp"
+#include "trace.hpp"
 
 #define LOG_MODULE_NAME ("SDLTexture")
 #include "log.hpp"
@@ -13,13 +14,17 @@ SDLTexture::SDLTexture(
     :
         width_(width),
         height_(height),
-        pixels_(nullptr)
+        pixels_(nullptr),
+        buffer_(nullptr),
+        pitch_(4 * width),
+        zero_copy_(access == SDL_TEXTUREACCESS_STREAMING),
+        locked_(false)
 {
     LOG_INFO << "Instance created." << std::endl;
 
     sdl_texture_ = SDL_CreateTexture(
         sdl_renderer->get(),
-        SDL_PIXELFORMAT_RGBA8888,
+        sdl_renderer->getTextureFormat(),
         access,
         width,
         height);
@@ -30,13 +35,17 @@ SDLTexture::SDLTexture(
         throw std::exception();
     }
 
-    pixels_ = new unsigned char[4 * (size_t)width * (size_t)height]();
+    if (!zero_copy_)
+        allocateBuffer();
 }
 
 SDLTexture::~SDLTexture()
 {
-    if (pixels_)
-        delete[] pixels_;
+    if (locked_)
+        SDL_UnlockTexture(sdl_texture_);
+
+    if (buffer_)
+        delete[] buffer_;
 
     if (sdl_texture_)
         SDL_DestroyTexture(sdl_texture_);
@@ -47,13 +56,64 @@ SDL_Texture *SDLTexture::get() const
     return sdl_texture_;
 }
 
+void SDLTexture::allocateBuffer()
+{
+    buffer_ = new unsigned char[4 * (size_t)width_ * (size_t)height_]();
+    pixels_ = buffer_;
+    pitch_ = 4 * width_;
+}
+
+void SDLTexture::lock()
+{
+    if (!zero_copy_ || locked_)
+        return;
+
+    TRACE_ZONE("SDL_LockTexture");
+    void *pixels;
+    int pitch;
+    if (SDL_LockTexture(sdl_texture_, nullptr, &pixels, &pitch))
+    {
+        LOG_WARNING << "Failure in SDL_LockTexture, using copy path. (" << SDL_GetError() << ")" << std::endl;
+        zero_copy_ = false;
+        allocateBuffer();
+        return;
+    }
+
+    pixels_ = static_cast<unsigned char *>(pixels);
+    pitch_ = pitch;
+    locked_ = true;
+}
+
 void SDLTexture::updateTexture()
 {
-    SDL_UpdateTexture(
-        sdl_texture_,
-        nullptr,
-        pixels_,
-        4 * width_);
+    TRACE_ZONE("SDL_UpdateTexture");
+    if (locked_)
+    {
+        SDL_UnlockTexture(sdl_texture_);
+        locked_ = false;
+        pixels_ = nullptr;
+        return;
+    }
+
+    if (buffer_)
+    {
+        SDL_UpdateTexture(
+            sdl_texture_,
+            nullptr,
+            buffer_,
+            pitch_);
+    }
+}
+
+void SDLTexture::updateTexture(const unsigned char *pixels, int pitch, const SDL_Rect &rect)
+{
+    TRACE_ZONE("SDL_UpdateTexture");
+    const unsigned char *origin = pixels + (size_t)rect.y * pitch + 4 * (size_t)rect.x;
+    if (SDL_UpdateTexture(sdl_texture_, &rect, origin, pitch))
+    {
+        LOG_ERROR << "Failure in SDL_UpdateTexture. (" << SDL_GetError() << ")" << std::endl;
+        throw std::exception();
+    }
 }
 
 unsigned char *SDLTexture::getPixels() const
@@ -61,6 +121,11 @@ unsigned char *SDLTexture::getPixels() const
     return pixels_;
 }
 
+int SDLTexture::getPitch() const
+{
+    return pitch_;
+}
+
 int SDLTexture::getWidth() const
 {
     return width_;
@@ -71,8 +136,13 @@ int SDLTexture::getHeight() const
     return height_;
 }
 
-void SDLTexture::clear()
+bool SDLTexture::isZeroCopy() const
 {
-    memset(pixels_, 0, 4 * width_ * height_ * sizeof(char));
+    return zero_copy_;
 }
 
+void SDLTexture::clear()
+{
+    // Locked texture memory is write only and may hold anything.
+    memset(pixels_, 0, (size_t)pitch_ * height_ * sizeof(char));
+}
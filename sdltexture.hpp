@@ -20,18 +20,38 @@ public:
 
     SDL_Texture *get() const;
 
+    // Makes getPixels() valid for a new frame. Streaming textures are locked
+    // and rendered into directly; if the driver refuses, the texture falls
+    // back to a heap buffer that updateTexture() copies from.
+    void lock();
+
+    // Unlocks the texture, or uploads the heap buffer in the fallback path.
     void updateTexture();
 
+    // Uploads one rectangle of pixels rendered elsewhere in the texture's
+    // format, bypassing lock(). pixels points at the origin of the whole
+    // image, not the rect.
+    void updateTexture(const unsigned char *pixels, int pitch, const SDL_Rect &rect);
+
 public:
     unsigned char *getPixels() const;
+    int getPitch() const;
     int getWidth() const;
     int getHeight() const;
+    bool isZeroCopy() const;
     void clear();
 
+private:
+    void allocateBuffer();
+
 private:
     SDL_Texture *sdl_texture_;
 
     unsigned char *pixels_;
+    unsigned char *buffer_;
+    int pitch_;
+    bool zero_copy_;
+    bool locked_;
 
     int width_;
     int height_;
@@ -2,21 +2,11 @@
 
 #include <SDL.h>
 
+#include "resolutions.hpp"
+
 #define LOG_MODULE_NAME ("SDLWindow")
 #include "log.hpp"
 
-const std::vector<std::pair<int, int>> SDLWindow::default_resolution_list_ = 
-{
-    std::pair<int, int>(320, 240),
-    std::pair<int, int>(640, 480),
-    std::pair<int, int>(800, 600),
-    std::pair<int, int>(1024, 768),
-    std::pair<int, int>(1280, 960),
-    std::pair<int, int>(1440, 1080),
-    std::pair<int, int>(1600, 1200),
-    std::pair<int, int>(2048, 1536)
-};
-
 SDLWindow::SDLWindow(const std::string &window_title) :
     sdl_window_(nullptr),
     window_title_(window_title)
@@ -41,11 +31,13 @@ SDLWindow::SDLWindow(const std::string &window_title) :
         LOG_INFO << "Display DPI vdpi (" << vdpi << ")" << std::endl;
     }
 
+    const auto &resolutions = getDefaultResolutionList();
+
     int selection = 0;
-    for (int i = 0; i < default_resolution_list_.size(); i++)
+    for (int i = 0; i < resolutions.size(); i++)
     {
-        if (default_resolution_list_[i].first < display_mode.w &&
-            default_resolution_list_[i].second < display_mode.h)
+        if (resolutions[i].first < display_mode.w &&
+            resolutions[i].second < display_mode.h)
         {
             selection = i;
             continue;
@@ -55,15 +47,15 @@ SDLWindow::SDLWindow(const std::string &window_title) :
 
     resolution_selection_ = selection;
 
-    LOG_INFO << "Window width (" << default_resolution_list_[selection].first << ")" << std::endl;
-    LOG_INFO << "Window height (" << default_resolution_list_[selection].second << ")" << std::endl;
+    LOG_INFO << "Window width (" << resolutions[selection].first << ")" << std::endl;
+    LOG_INFO << "Window height (" << resolutions[selection].second << ")" << std::endl;
 
     sdl_window_ = SDL_CreateWindow(
         window_title.c_str(),
         SDL_WINDOWPOS_CENTERED,
         SDL_WINDOWPOS_CENTERED,
-        default_resolution_list_[selection].first,
-        default_resolution_list_[selection].second,
+        resolutions[selection].first,
+        resolutions[selection].second,
         SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
 
     if (!sdl_window_)
@@ -86,7 +78,7 @@ SDL_Window *SDLWindow::get() const
 
 const std::pair<int, int> &SDLWindow::getDefaultResolution() const
 {
-    return default_resolution_list_[resolution_selection_];
+    return getDefaultResolutionList()[resolution_selection_];
 }
 
 void SDLWindow::setWindowTitle(const std::string& window_title)
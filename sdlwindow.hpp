@@ -22,8 +22,6 @@ private:
     SDL_Window *sdl_window_;
 
 private:
-    static const std::vector<std::pair<int, int>> default_resolution_list_;
-
     int resolution_selection_;
 
     std::string window_title_;
@@ -0,0 +1,106 @@
+#include "threadpool.hpp"
+
+#include "perfcounters.hpp"
+#include "trace.hpp"
+
+#define LOG_MODULE_NAME ("ThreadPool")
+#include "log.hpp"
+
+ThreadPool::ThreadPool(int thread_count) :
+    invoke_(nullptr),
+    context_(nullptr),
+    count_(0),
+    next_(0),
+    pending_(0),
+    generation_(0),
+    quit_(false)
+{
+    if (thread_count < 0)
+        thread_count = std::max(0, (int)std::thread::hardware_concurrency() - 1);
+
+    LOG_INFO << "Worker threads (" << thread_count << ")" << std::endl;
+
+    for (int i = 0; i < thread_count; i++)
+        threads_.emplace_back(&ThreadPool::worker, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        quit_ = true;
+    }
+    start_.notify_all();
+
+    for (auto &thread : threads_)
+        thread.join();
+}
+
+int ThreadPool::getThreadCount() const
+{
+    return threads_.size();
+}
+
+void ThreadPool::drain()
+{
+    TRACE_ZONE("jobs");
+    for (int i = next_.fetch_add(1); i < count_; i = next_.fetch_add(1))
+        invoke_(context_, i);
+}
+
+void ThreadPool::run(int count, Invoke invoke, const void *context)
+{
+    if (count <= 0)
+        return;
+
+    if (threads_.empty() || count == 1)
+    {
+        for (int i = 0; i < count; i++)
+            invoke(context, i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        invoke_ = invoke;
+        context_ = context;
+        count_ = count;
+        next_ = 0;
+        pending_ = threads_.size();
+        generation_++;
+    }
+    start_.notify_all();
+
+    drain();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] { return pending_ == 0; });
+    invoke_ = nullptr;
+    context_ = nullptr;
+}
+
+void ThreadPool::worker()
+{
+    TRACE_THREAD_NAME("worker");
+    PerfCounters::registerThread();
+    unsigned long long generation = 0;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            start_.wait(lock, [this, generation] { return quit_ || generation_ != generation; });
+            if (quit_)
+                return;
+            generation = generation_;
+        }
+
+        drain();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_--;
+        }
+        done_.notify_one();
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for data parallel loops inside a frame. The
+// calling thread takes part in the work, so a pool of N threads keeps N + 1
+// cores busy.
+class ThreadPool
+{
+public:
+    ThreadPool(int thread_count = -1);
+    ~ThreadPool();
+
+    int getThreadCount() const;
+
+    // Runs job(i) for every i in [0, count) and returns once all of them
+    // have finished. Takes the job by reference rather than as a
+    // std::function, which would allocate for lambdas capturing more than
+    // a couple of pointers.
+    template <typename Job>
+    void parallelFor(int count, const Job &job)
+    {
+        run(
+            count,
+            [](const void *context, int i)
+            {
+                (*static_cast<const Job *>(context))(i);
+            },
+            &job);
+    }
+
+private:
+    using Invoke = void (*)(const void *context, int i);
+
+    void run(int count, Invoke invoke, const void *context);
+
+    void worker();
+
+    void drain();
+
+private:
+    std::vector<std::thread> threads_;
+
+    std::mutex mutex_;
+    std::condition_variable start_;
+    std::condition_variable done_;
+
+    Invoke invoke_;
+    const void *context_;
+    int count_;
+    std::atomic<int> next_;
+    int pending_;
+    unsigned long long generation_;
+    bool quit_;
+};
@@ -0,0 +1,149 @@
+#include "tilemask.hpp"
+
+#include <algorithm>
+
+TileMask::TileMask() :
+    width_(0),
+    height_(0),
+    tiles_x_(0),
+    tiles_y_(0)
+{
+}
+
+void TileMask::reset(int width, int height)
+{
+    width_ = width;
+    height_ = height;
+    tiles_x_ = (width + TILE - 1) / TILE;
+    tiles_y_ = (height + TILE - 1) / TILE;
+    tiles_.assign((size_t)tiles_x_ * tiles_y_, 0);
+}
+
+int TileMask::getWidth() const
+{
+    return width_;
+}
+
+int TileMask::getHeight() const
+{
+    return height_;
+}
+
+int TileMask::getTileCount() const
+{
+    return tiles_.size();
+}
+
+int TileMask::getSetCount() const
+{
+    return std::count(tiles_.begin(), tiles_.end(), 1);
+}
+
+bool TileMask::isEmpty() const
+{
+    return std::find(tiles_.begin(), tiles_.end(), 1) == tiles_.end();
+}
+
+void TileMask::setAll()
+{
+    std::fill(tiles_.begin(), tiles_.end(), 1);
+}
+
+void TileMask::setPixels(int x0, int y0, int x1, int y1)
+{
+    x0 = std::max(0, x0);
+    y0 = std::max(0, y0);
+    x1 = std::min(width_, x1);
+    y1 = std::min(height_, y1);
+    if (x0 >= x1 || y0 >= y1)
+        return;
+
+    for (int ty = y0 / TILE; ty <= (y1 - 1) / TILE; ty++)
+        for (int tx = x0 / TILE; tx <= (x1 - 1) / TILE; tx++)
+            tiles_[(size_t)ty * tiles_x_ + tx] = 1;
+}
+
+bool TileMask::test(int tile_x, int tile_y) const
+{
+    return tiles_[(size_t)tile_y * tiles_x_ + tile_x] != 0;
+}
+
+bool TileMask::testPixels(int x0, int y0, int x1, int y1) const
+{
+    x0 = std::max(0, x0);
+    y0 = std::max(0, y0);
+    x1 = std::min(width_, x1);
+    y1 = std::min(height_, y1);
+    if (x0 >= x1 || y0 >= y1)
+        return false;
+
+    for (int ty = y0 / TILE; ty <= (y1 - 1) / TILE; ty++)
+        for (int tx = x0 / TILE; tx <= (x1 - 1) / TILE; tx++)
+            if (tiles_[(size_t)ty * tiles_x_ + tx])
+                return true;
+    return false;
+}
+
+TileMask &TileMask::operator|=(const TileMask &rhs)
+{
+    for (size_t i = 0; i < tiles_.size() && i < rhs.tiles_.size(); i++)
+        tiles_[i] |= rhs.tiles_[i];
+    return *this;
+}
+
+void TileMask::getRects(std::vector<Rect> &rects) const
+{
+    // Rects still open for merging with the current row, in tile units.
+    // Per thread scratch, so a frame's call does not allocate.
+    thread_local std::vector<Rect> open;
+    thread_local std::vector<Rect> next;
+    open.clear();
+
+    auto close = [this, &rects](const Rect &r)
+    {
+        Rect pixels;
+        pixels.x = r.x * TILE;
+        pixels.y = r.y * TILE;
+        pixels.width = std::min(width_, (r.x + r.width) * TILE) - pixels.x;
+        pixels.height = std::min(height_, (r.y + r.height) * TILE) - pixels.y;
+        rects.push_back(pixels);
+    };
+
+    for (int ty = 0; ty < tiles_y_; ty++)
+    {
+        next.clear();
+        int tx = 0;
+        while (tx < tiles_x_)
+        {
+            if (!test(tx, ty))
+            {
+                tx++;
+                continue;
+            }
+            int end = tx;
+            while (end < tiles_x_ && test(end, ty))
+                end++;
+
+            Rect run = { tx, ty, end - tx, 1 };
+            auto it = std::find_if(
+                open.begin(),
+                open.end(),
+                [&run](const Rect &r) { return r.x == run.x && r.width == run.width; });
+            if (it != open.end())
+            {
+                run = *it;
+                run.height++;
+                open.erase(it);
+            }
+            next.push_back(run);
+            tx = end;
+        }
+
+        for (const Rect &r : open)
+            close(r);
+        open.swap(next);
+    }
+
+    for (const Rect &r : open)
+        close(r);
+}
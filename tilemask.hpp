@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// One bit of state per TILE x TILE pixel block of a framebuffer, for
+// tracking which parts of a frame changed.
+class TileMask
+{
+public:
+    struct Rect
+    {
+        int x;
+        int y;
+        int width;
+        int height;
+    };
+
+    TileMask();
+
+    // Resizes for a width x height framebuffer and clears every tile.
+    void reset(int width, int height);
+
+    int getWidth() const;
+
+    int getHeight() const;
+
+    int getTileCount() const;
+
+    int getSetCount() const;
+
+    bool isEmpty() const;
+
+    void setAll();
+
+    // Marks the tiles overlapping pixels [x0, x1) x [y0, y1), clamped to the
+    // framebuffer.
+    void setPixels(int x0, int y0, int x1, int y1);
+
+    bool test(int tile_x, int tile_y) const;
+
+    // True when any tile overlapping the pixel rectangle is set.
+    bool testPixels(int x0, int y0, int x1, int y1) const;
+
+    TileMask &operator|=(const TileMask &rhs);
+
+    // Set tiles as pixel rectangles clamped to the framebuffer: runs along
+    // each row of tiles, merged with identical runs in the rows below.
+    void getRects(std::vector<Rect> &rects) const;
+
+    constexpr static int TILE = 64;
+
+private:
+    int width_;
+    int height_;
+    int tiles_x_;
+    int tiles_y_;
+    std::vector<uint8_t> tiles_;
+};
@@ -0,0 +1,124 @@
+#include "trace.hpp"
+
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+
+#define LOG_MODULE_NAME ("Trace")
+#include "log.hpp"
+
+namespace
+{
+    std::mutex buffers_mutex;
+
+    // Timestamps are microseconds from the start of the process.
+    const Trace::Clock::time_point origin = Trace::Clock::now();
+
+    double microseconds(Trace::Clock::time_point t)
+    {
+        return std::chrono::duration<double, std::micro>(t - origin).count();
+    }
+}
+
+std::vector<Trace::Buffer *> &Trace::getBuffers()
+{
+    static std::vector<Buffer *> buffers;
+    return buffers;
+}
+
+Trace::Buffer &Trace::getBuffer()
+{
+    thread_local Buffer *buffer = nullptr;
+    if (!buffer)
+    {
+        buffer = new Buffer();
+        buffer->events.resize(BUFFER_SIZE);
+        buffer->written = 0;
+
+        std::lock_guard<std::mutex> lock(buffers_mutex);
+        buffer->thread_id = getBuffers().size() + 1;
+        buffer->thread_name = "thread " + std::to_string(buffer->thread_id);
+        getBuffers().push_back(buffer);
+    }
+    return *buffer;
+}
+
+void Trace::push(const Event &event)
+{
+    Buffer &buffer = getBuffer();
+    // Only this thread writes the ring; the release store publishes the
+    // event to write().
+    const uint64_t written = buffer.written.load(std::memory_order_relaxed);
+    buffer.events[written & (BUFFER_SIZE - 1)] = event;
+    buffer.written.store(written + 1, std::memory_order_release);
+}
+
+void Trace::complete(const char *name, Clock::time_point start, Clock::time_point end)
+{
+    push(Event{ name, start, end, 0.0, COMPLETE });
+}
+
+void Trace::frame(long long number)
+{
+    const Clock::time_point now = Clock::now();
+    push(Event{ "frame", now, now, (double)number, FRAME });
+}
+
+void Trace::counter(const char *name, double value)
+{
+    const Clock::time_point now = Clock::now();
+    push(Event{ name, now, now, value, COUNTER });
+}
+
+void Trace::setThreadName(const char *name)
+{
+    Buffer &buffer = getBuffer();
+    std::lock_guard<std::mutex> lock(buffers_mutex);
+    buffer.thread_name = name;
+}
+
+void Trace::write(const std::string &path)
+{
+    std::ofstream out(path);
+    if (!out)
+    {
+        LOG_ERROR << "Failure in opening trace file. (" << path << ")" << std::endl;
+        throw std::exception();
+    }
+
+    std::lock_guard<std::mutex> lock(buffers_mutex);
+
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    out << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"sw-renderer\"}}";
+    for (const Buffer *buffer : getBuffers())
+    {
+        out << ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->thread_id
+            << ", \"args\": {\"name\": \"" << buffer->thread_name << "\"}}";
+
+        const uint64_t written = buffer->written.load(std::memory_order_acquire);
+        const uint64_t first = written > BUFFER_SIZE ? written - BUFFER_SIZE : 0;
+        for (uint64_t i = first; i < written; i++)
+        {
+            const Event &event = buffer->events[i & (BUFFER_SIZE - 1)];
+            out << ",\n{\"name\": \"" << event.name << "\", \"pid\": 1, \"tid\": " << buffer->thread_id
+                << ", \"ts\": " << microseconds(event.start);
+            switch (event.type)
+            {
+            case COMPLETE:
+                out << ", \"ph\": \"X\", \"dur\": "
+                    << std::chrono::duration<double, std::micro>(event.end - event.start).count() << "}";
+                break;
+            case FRAME:
+                out << ", \"ph\": \"i\", \"s\": \"g\", \"args\": {\"number\": " << (long long)event.value << "}}";
+                break;
+            case COUNTER:
+                out << ", \"ph\": \"C\", \"args\": {\"value\": " << event.value << "}}";
+                break;
+            }
+        }
+    }
+    out << "\n]}\n";
+
+    LOG_INFO << "Trace written. (" << path << ")" << std::endl;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Timeline of scoped zones, frame markers and counters, written as Chrome
+// trace-event JSON for chrome://tracing and ui.perfetto.dev. Every thread
+// appends to a ring buffer of its own, so recording takes no lock and never
+// allocates after the first event; write() merges the rings. A ring keeps
+// the latest BUFFER_SIZE events, a few hundred frames of a busy scene.
+//
+// Use the TRACE_ macros below rather than the class: they compile to
+// nothing unless SWR_TRACE is defined (cmake -DSWR_TRACE=ON).
+class Trace
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Records a zone from construction to destruction. name must outlive
+    // the trace; string literals do.
+    class Zone
+    {
+    public:
+        Zone(const char *name) :
+            name_(name),
+            start_(Clock::now())
+        {
+        }
+
+        ~Zone()
+        {
+            complete(name_, start_, Clock::now());
+        }
+
+    private:
+        const char *name_;
+        Clock::time_point start_;
+    };
+
+    static void complete(const char *name, Clock::time_point start, Clock::time_point end);
+
+    static void frame(long long number);
+
+    static void counter(const char *name, double value);
+
+    static void setThreadName(const char *name);
+
+    // Writes every ring, oldest event first. Rings still being written to
+    // may lose their oldest events to the writer, so call it between
+    // frames or on exit.
+    static void write(const std::string &path);
+
+private:
+    enum Type
+    {
+        COMPLETE,
+        FRAME,
+        COUNTER
+    };
+
+    struct Event
+    {
+        const char *name;
+        Clock::time_point start;
+        Clock::time_point end;
+        double value;
+        Type type;
+    };
+
+    struct Buffer
+    {
+        std::vector<Event> events;
+        std::atomic<uint64_t> written;
+        std::string thread_name;
+        int thread_id;
+    };
+
+    // The calling thread's ring, registered on first use.
+    static Buffer &getBuffer();
+
+    // Every ring ever registered. Rings are never freed, so threads that
+    // have exited still show up in the trace.
+    static std::vector<Buffer *> &getBuffers();
+
+    static void push(const Event &event);
+
+    constexpr static int BUFFER_SIZE = 1 << 18;
+};
+
+#ifdef SWR_TRACE
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_ZONE(name) Trace::Zone TRACE_CONCAT(trace_zone_, __LINE__)(name)
+#define TRACE_COMPLETE(name, start, end) Trace::complete(name, start, end)
+#define TRACE_FRAME(number) Trace::frame(number)
+#define TRACE_COUNTER(name, value) Trace::counter(name, value)
+#define TRACE_THREAD_NAME(name) Trace::setThreadName(name)
+#else
+#define TRACE_ZONE(name) do {} while (false)
+#define TRACE_COMPLETE(name, start, end) do {} while (false)
+#define TRACE_FRAME(number) do {} while (false)
+#define TRACE_COUNTER(name, value) do {} while (false)
+#define TRACE_THREAD_NAME(name) do {} while (false)
+#endif
@@ -1,7 +1,8 @@
 #include "triangle.hpp"
 
-#include <vector>
+#include <algorithm>
 #include <limits>
+#include <utility>
 
 void line(
 	int x1,
@@ -115,7 +116,7 @@ void line(
 	}
 }
 
-void triangle(
+void triangleSpans(
 	int x1,
 	int y1,
 	double z1,
@@ -125,7 +126,7 @@ void triangle(
 	int x3,
 	int y3,
 	double z3,
-	std::function<void(int x, int y, double z)> dotproc)
+	std::vector<Span> &spans)
 {
 	int min_y = std::min(y1, std::min(y2, y3));
 	int max_y = std::max(y1, std::max(y2, y3));
@@ -134,15 +135,10 @@ void triangle(
 	y2 -= min_y;
 	y3 -= min_y;
 
-	std::vector<std::pair<int, double>> mins;
-	std::vector<std::pair<int, double>> maxs;
-	mins.reserve(dy + 1);
-	maxs.reserve(dy + 1);
-	for (int i = 0; i < dy + 1 ; i++)
-	{
-		mins.push_back(std::make_pair(std::numeric_limits<int>::max(), 0.0));
-		maxs.push_back(std::make_pair(std::numeric_limits<int>::min(), 0.0));
-	}
+	thread_local std::vector<std::pair<int, double>> mins;
+	thread_local std::vector<std::pair<int, double>> maxs;
+	mins.assign(dy + 1, std::make_pair(std::numeric_limits<int>::max(), 0.0));
+	maxs.assign(dy + 1, std::make_pair(std::numeric_limits<int>::min(), 0.0));
 
 	line(x1, y1, z1, x2, y2, z2, mins, maxs);
 	line(x2, y2, z2, x3, y3, z3, mins, maxs);
@@ -150,14 +146,15 @@ void triangle(
 
 	for (int j = 0; j < dy; j++)
 	{
-		double z = mins[j].second;
-		int dx = std::max(1, maxs[j].first - mins[j].first);
-		double dz = (maxs[j].second - mins[j].second) / dx;
-		const int k = maxs[j].first;
-		for (int i = mins[j].first; i < k; i++)
-		{
-			dotproc(i, j + min_y, z);
-			z += dz;
-		}
+		const int count = maxs[j].first - mins[j].first;
+		if (count <= 0)
+			continue;
+		Span span;
+		span.y = j + min_y;
+		span.x = mins[j].first;
+		span.count = count;
+		span.z = mins[j].second;
+		span.dz = (maxs[j].second - mins[j].second) / count;
+		spans.push_back(span);
 	}
 }
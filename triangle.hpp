@@ -1,7 +1,19 @@
 #pragma once
-#include <functional>
+#include <vector>
 
-void triangle(
+// One row of a scan converted triangle: count pixels starting at (x, y),
+// depth z at the first pixel and z + i * dz after that.
+struct Span
+{
+	int y;
+	int x;
+	int count;
+	double z;
+	double dz;
+};
+
+// Appends the spans covering the triangle, one per row.
+void triangleSpans(
 	int x1,
 	int y1,
 	double z1,
@@ -11,5 +23,33 @@ void triangle(
 	int x3,
 	int y3,
 	double z3,
-	std::function<void(int x, int y, double z)> dotproc);
+	std::vector<Span> &spans);
 
+// Per-pixel form on top of triangleSpans. The callback is a template
+// parameter, so it is inlined rather than called through std::function.
+template <typename DotProc>
+void triangle(
+	int x1,
+	int y1,
+	double z1,
+	int x2,
+	int y2,
+	double z2,
+	int x3,
+	int y3,
+	double z3,
+	DotProc dotproc)
+{
+	thread_local std::vector<Span> spans;
+	spans.clear();
+	triangleSpans(x1, y1, z1, x2, y2, z2, x3, y3, z3, spans);
+	for (const Span &span : spans)
+	{
+		double z = span.z;
+		for (int i = span.x; i < span.x + span.count; i++)
+		{
+			dotproc(i, span.y, z);
+			z += span.dz;
+		}
+	}
+}
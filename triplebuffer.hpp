@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+
+// Lock-free single producer, single consumer mailbox that always hands the
+// consumer the newest published value. The producer fills getBack() and
+// publishes it; the consumer acquires and reads getFront(). Values the
+// consumer never got around to acquiring are overwritten, not queued.
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() :
+        back_(0),
+        middle_(1),
+        front_(2)
+    {
+    }
+
+    TripleBuffer(const TripleBuffer &) = delete;
+    TripleBuffer &operator=(const TripleBuffer &) = delete;
+
+    // Producer side.
+    T &getBack()
+    {
+        return slots_[back_];
+    }
+
+    void publish()
+    {
+        back_ = middle_.exchange(back_ | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    // True while a published value has not been acquired yet. Either side.
+    bool isPending() const
+    {
+        return (middle_.load(std::memory_order_acquire) & FRESH) != 0;
+    }
+
+    // Consumer side. Returns false, keeping the current front, when nothing
+    // new was published since the last call.
+    bool acquire()
+    {
+        if (!isPending())
+            return false;
+        front_ = middle_.exchange(front_, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+
+    T &getFront()
+    {
+        return slots_[front_];
+    }
+
+private:
+    constexpr static int INDEX = 3;
+    constexpr static int FRESH = 4;
+
+    T slots_[3];
+    int back_;
+    std::atomic<int> middle_;
+    int front_;
+};
@@ -0,0 +1,225 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <SDL.h>
+
+#include "framebuffer.hpp"
+#include "sdlrenderer.hpp"
+
+#define LOG_MODULE_NAME ("UploadBench")
+#include "log.hpp"
+
+namespace
+{
+    // Every packed 32 bit format the renderer can write.
+    const Uint32 CANDIDATE_FORMATS[] =
+    {
+        SDL_PIXELFORMAT_RGBA8888,
+        SDL_PIXELFORMAT_RGBX8888,
+        SDL_PIXELFORMAT_ARGB8888,
+        SDL_PIXELFORMAT_RGB888,
+        SDL_PIXELFORMAT_ABGR8888,
+        SDL_PIXELFORMAT_BGR888,
+        SDL_PIXELFORMAT_BGRA8888,
+        SDL_PIXELFORMAT_BGRX8888
+    };
+
+    struct Result
+    {
+        double upload_mean;
+        double upload_median;
+        double frame_mean;
+    };
+
+    double mean(const std::vector<double> &values)
+    {
+        double total = 0.0;
+        for (double v : values)
+            total += v;
+        return total / values.size();
+    }
+
+    double median(std::vector<double> values)
+    {
+        std::sort(values.begin(), values.end());
+        return values[values.size() / 2];
+    }
+
+    // Uploads a full frame per iteration and presents it, without vsync.
+    // Returns false if the driver has no texture of this format.
+    bool measure(
+        SDL_Renderer *sdl_renderer,
+        Uint32 sdl_format,
+        int width,
+        int height,
+        int frames,
+        Result &result)
+    {
+        PixelFormat format;
+        if (!SDLRenderer::toPixelFormat(sdl_format, format))
+            return false;
+
+        SDL_Texture *texture = SDL_CreateTexture(
+            sdl_renderer,
+            sdl_format,
+            SDL_TEXTUREACCESS_STREAMING,
+            width,
+            height);
+        if (!texture)
+            return false;
+
+        // A gradient written in the format under test, so every candidate
+        // uploads the same image.
+        std::vector<uint32_t> pixels((size_t)width * height);
+        for (int y = 0; y < height; y++)
+        {
+            for (int x = 0; x < width; x++)
+            {
+                pixels[(size_t)y * width + x] = packPixel(
+                    format,
+                    glm::dvec3((double)x / width, (double)y / height, 0.5));
+            }
+        }
+
+        constexpr int WARMUP_FRAMES = 10;
+
+        std::vector<double> uploads;
+        std::vector<double> totals;
+        uploads.reserve(frames);
+        totals.reserve(frames);
+        for (int frame = -WARMUP_FRAMES; frame < frames; frame++)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            SDL_UpdateTexture(texture, nullptr, pixels.data(), width * sizeof(uint32_t));
+            const auto uploaded = std::chrono::steady_clock::now();
+            SDL_RenderCopy(sdl_renderer, texture, nullptr, nullptr);
+            SDL_RenderPresent(sdl_renderer);
+            const auto end = std::chrono::steady_clock::now();
+
+            if (frame < 0)
+                continue;
+            uploads.push_back(std::chrono::duration<double, std::milli>(uploaded - start).count());
+            totals.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        }
+
+        SDL_DestroyTexture(texture);
+
+        result.upload_mean = mean(uploads);
+        result.upload_median = median(uploads);
+        result.frame_mean = mean(totals);
+        return true;
+    }
+}
+
+// Measures what uploading and presenting a frame costs in each pixel format
+// on the current SDL render driver. Formats the driver lists natively should
+// come out ahead; the one marked "preferred" is what the app picks.
+int main(int argc, char **argv)
+{
+    std::vector<std::string> args(argv, argv + argc);
+
+    int frames = 200;
+    int width = 1024;
+    int height = 768;
+    for (int i = 1; i < (int)args.size(); i++)
+    {
+        if (args[i] == "--frames" && i + 1 < (int)args.size())
+            frames = std::max(1, std::stoi(args[++i]));
+        else if (args[i] == "--size" && i + 1 < (int)args.size())
+        {
+            const std::string size = args[++i];
+            const size_t x = size.find('x');
+            if (x == std::string::npos)
+            {
+                LOG_ERROR << "Failure in --size, expected WxH. (" << size << ")" << std::endl;
+                return EXIT_FAILURE;
+            }
+            width = std::max(1, std::stoi(size.substr(0, x)));
+            height = std::max(1, std::stoi(size.substr(x + 1)));
+        }
+    }
+
+    if (SDL_Init(SDL_INIT_VIDEO))
+    {
+        LOG_ERROR << "Failure in SDL_Init. (" << SDL_GetError() << ")" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    SDL_Window *sdl_window = SDL_CreateWindow(
+        "swr-upload-bench",
+        SDL_WINDOWPOS_CENTERED,
+        SDL_WINDOWPOS_CENTERED,
+        width,
+        height,
+        SDL_WINDOW_HIDDEN);
+    if (!sdl_window)
+    {
+        LOG_ERROR << "Failure in SDL_CreateWindow. (" << SDL_GetError() << ")" << std::endl;
+        SDL_Quit();
+        return EXIT_FAILURE;
+    }
+
+    SDL_Renderer *sdl_renderer = SDL_CreateRenderer(sdl_window, -1, 0);
+    if (!sdl_renderer)
+    {
+        LOG_ERROR << "Failure in SDL_CreateRenderer. (" << SDL_GetError() << ")" << std::endl;
+        SDL_DestroyWindow(sdl_window);
+        SDL_Quit();
+        return EXIT_FAILURE;
+    }
+
+    SDL_RendererInfo info;
+    SDL_GetRendererInfo(sdl_renderer, &info);
+
+    // Same rule as SDLRenderer: the first supported entry of the list.
+    Uint32 preferred = SDL_PIXELFORMAT_UNKNOWN;
+    for (Uint32 i = 0; i < info.num_texture_formats; i++)
+    {
+        PixelFormat format;
+        if (SDLRenderer::toPixelFormat(info.texture_formats[i], format))
+        {
+            preferred = info.texture_formats[i];
+            break;
+        }
+    }
+
+    std::cout << "driver " << info.name
+        << " size " << width << "x" << height
+        << " frames " << frames
+        << std::endl;
+
+    for (Uint32 sdl_format : CANDIDATE_FORMATS)
+    {
+        const bool native = std::find(
+            info.texture_formats,
+            info.texture_formats + info.num_texture_formats,
+            sdl_format) != info.texture_formats + info.num_texture_formats;
+
+        Result result;
+        if (!measure(sdl_renderer, sdl_format, width, height, frames, result))
+        {
+            std::cout << std::left << std::setw(24) << SDL_GetPixelFormatName(sdl_format)
+                << " unsupported" << std::endl;
+            continue;
+        }
+
+        std::cout << std::left << std::setw(24) << SDL_GetPixelFormatName(sdl_format)
+            << std::right << std::fixed << std::setprecision(3)
+            << " upload mean " << result.upload_mean << " ms"
+            << " median " << result.upload_median << " ms"
+            << " frame " << result.frame_mean << " ms"
+            << (native ? " native" : "")
+            << (sdl_format == preferred ? " preferred" : "")
+            << std::endl;
+    }
+
+    SDL_DestroyRenderer(sdl_renderer);
+    SDL_DestroyWindow(sdl_window);
+    SDL_Quit();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,211 @@
+#include "vertexcache.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "mesh.hpp"
+
+namespace
+{
+    constexpr int CACHE_SIZE = 32;
+    constexpr double CACHE_DECAY_POWER = 1.5;
+    constexpr double LAST_TRIANGLE_SCORE = 0.75;
+    constexpr double VALENCE_BOOST_SCALE = 2.0;
+    constexpr double VALENCE_BOOST_POWER = 0.5;
+
+    double vertexScore(int cache_position, int remaining)
+    {
+        if (remaining == 0)
+            return -1.0;
+
+        double score = 0.0;
+        if (cache_position >= 0)
+        {
+            if (cache_position < 3)
+            {
+                // The three vertices of the last triangle get a fixed score
+                // so the next triangle does not simply reuse the same edge.
+                score = LAST_TRIANGLE_SCORE;
+            }
+            else
+            {
+                const double scaler = 1.0 / (CACHE_SIZE - 3);
+                score = std::pow(1.0 - (cache_position - 3) * scaler, CACHE_DECAY_POWER);
+            }
+        }
+
+        // Favour vertices with few triangles left so they are finished off
+        // instead of leaving lone triangles behind.
+        score += VALENCE_BOOST_SCALE * std::pow((double)remaining, -VALENCE_BOOST_POWER);
+        return score;
+    }
+}
+
+std::vector<int> vertexCacheOrder(
+    const std::vector<int> &indices,
+    int vertex_count)
+{
+    const int triangle_count = indices.size() / 3;
+
+    std::vector<int> remaining(vertex_count, 0);
+    for (int index : indices)
+        remaining[index]++;
+
+    // Triangles of each vertex, packed; the live ones are kept in the first
+    // remaining[v] slots.
+    std::vector<int> offsets(vertex_count + 1, 0);
+    for (int v = 0; v < vertex_count; v++)
+        offsets[v + 1] = offsets[v] + remaining[v];
+    std::vector<int> vertex_triangles(indices.size());
+    {
+        std::vector<int> fill(offsets.begin(), offsets.end() - 1);
+        for (int i = 0; i < (int)indices.size(); i++)
+            vertex_triangles[fill[indices[i]]++] = i / 3;
+    }
+
+    std::vector<int> cache_position(vertex_count, -1);
+    std::vector<double> vertex_score(vertex_count);
+    for (int v = 0; v < vertex_count; v++)
+        vertex_score[v] = vertexScore(-1, remaining[v]);
+
+    std::vector<double> triangle_score(triangle_count);
+    std::vector<bool> emitted(triangle_count, false);
+    for (int t = 0; t < triangle_count; t++)
+        triangle_score[t] =
+            vertex_score[indices[3 * t + 0]] +
+            vertex_score[indices[3 * t + 1]] +
+            vertex_score[indices[3 * t + 2]];
+
+    std::vector<int> order;
+    order.reserve(triangle_count);
+
+    std::vector<int> cache;
+    std::vector<int> next_cache;
+    cache.reserve(CACHE_SIZE + 3);
+    next_cache.reserve(CACHE_SIZE + 3);
+
+    int best = -1;
+    int cursor = 0;
+    while ((int)order.size() < triangle_count)
+    {
+        if (best < 0)
+        {
+            // Nothing in the cache touches a live triangle; take the best of
+            // the rest. The cursor only moves forward, which keeps the scan
+            // linear over the whole run.
+            double best_score = -1.0;
+            for (int t = cursor; t < triangle_count; t++)
+            {
+                if (emitted[t])
+                {
+                    if (t == cursor)
+                        cursor++;
+                    continue;
+                }
+                if (triangle_score[t] > best_score)
+                {
+                    best_score = triangle_score[t];
+                    best = t;
+                }
+            }
+        }
+
+        const int t = best;
+        order.push_back(t);
+        emitted[t] = true;
+
+        // Move the triangle's vertices to the front of the LRU cache.
+        next_cache.clear();
+        for (int k = 0; k < 3; k++)
+        {
+            const int v = indices[3 * t + k];
+            next_cache.push_back(v);
+
+            int *begin = &vertex_triangles[offsets[v]];
+            int *end = begin + remaining[v];
+            std::swap(*std::find(begin, end, t), *(end - 1));
+            remaining[v]--;
+        }
+        for (int v : cache)
+            if (v != indices[3 * t + 0] && v != indices[3 * t + 1] && v != indices[3 * t + 2])
+                next_cache.push_back(v);
+        std::swap(cache, next_cache);
+
+        for (int i = 0; i < (int)cache.size(); i++)
+        {
+            const int v = cache[i];
+            cache_position[v] = i < CACHE_SIZE ? i : -1;
+            vertex_score[v] = vertexScore(cache_position[v], remaining[v]);
+        }
+
+        // Rescore the live triangles of every vertex that moved and pick
+        // the best of them.
+        best = -1;
+        double best_score = -1.0;
+        for (int v : cache)
+        {
+            for (int i = 0; i < remaining[v]; i++)
+            {
+                const int u = vertex_triangles[offsets[v] + i];
+                const double score =
+                    vertex_score[indices[3 * u + 0]] +
+                    vertex_score[indices[3 * u + 1]] +
+                    vertex_score[indices[3 * u + 2]];
+                triangle_score[u] = score;
+                if (score > best_score)
+                {
+                    best_score = score;
+                    best = u;
+                }
+            }
+        }
+
+        if (cache.size() > CACHE_SIZE)
+            cache.resize(CACHE_SIZE);
+    }
+
+    return order;
+}
+
+double computeAcmr(
+    const std::vector<int> &indices,
+    int cache_size)
+{
+    if (indices.empty())
+        return 0.0;
+
+    std::vector<int> fifo(cache_size, -1);
+    int head = 0;
+    int misses = 0;
+    for (int index : indices)
+    {
+        if (std::find(fifo.begin(), fifo.end(), index) != fifo.end())
+            continue;
+        fifo[head] = index;
+        head = (head + 1) % cache_size;
+        misses++;
+    }
+    return misses / (indices.size() / 3.0);
+}
+
+void optimizeVertexCache(Mesh &mesh)
+{
+    const auto &indices = mesh.getIndices();
+    std::vector<int> order = vertexCacheOrder(indices, mesh.getVertices().size());
+
+    // Sources that are already strip ordered (the teapot's patches are) can
+    // beat the greedy optimizer. Keep their order and only reorder the
+    // vertex fetches.
+    std::vector<int> reordered;
+    reordered.reserve(indices.size());
+    for (int t : order)
+        for (int k = 0; k < 3; k++)
+            reordered.push_back(indices[3 * t + k]);
+    if (computeAcmr(reordered) > computeAcmr(indices))
+    {
+        for (int i = 0; i < (int)order.size(); i++)
+            order[i] = i;
+    }
+
+    mesh.reorder(order);
+}
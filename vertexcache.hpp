@@ -0,0 +1,24 @@
+#pragma once
+
+#include <vector>
+
+class Mesh;
+
+// Triangle order for the post-transform vertex cache, after Tom Forsyth's
+// "Linear-Speed Vertex Cache Optimisation". Returns triangle indices in the
+// order they should be drawn.
+std::vector<int> vertexCacheOrder(
+    const std::vector<int> &indices,
+    int vertex_count);
+
+// Average cache miss ratio: transformed vertices per triangle for a FIFO
+// cache of the given size. 0.5 is the ideal for large regular meshes, 3.0
+// is no reuse at all.
+double computeAcmr(
+    const std::vector<int> &indices,
+    int cache_size = 16);
+
+// Reorders the triangles of the mesh for vertex reuse, unless the source
+// order is already better, and then lays the vertices out in first use
+// order.
+void optimizeVertexCache(Mesh &mesh);